@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+
+
+// Арена для буферов одного запуска: память берётся у кучи большими блоками и раздаётся подряд,
+// а освобождается вся сразу (reset). После reset память остаётся у арены, так что следующий запуск
+// того же размера к куче не обращается. Объекты в арене не разрушаются - только простые типы.
+class BumpArena {
+public:
+    // block - размер первого блока в байтах; следующие вдвое больше предыдущего
+    explicit BumpArena(size_t block = size_t(1) << 16) : next_block_(block) {}
+
+    BumpArena(BumpArena&&) = default;
+    BumpArena& operator=(BumpArena&&) = default;
+    BumpArena(const BumpArena&) = delete;
+    BumpArena& operator=(const BumpArena&) = delete;
+
+    // count неинициализированных T
+    template <class T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena does not run destructors");
+        return static_cast<T*>(allocate_bytes(count * sizeof(T), alignof(T)));
+    }
+
+    // всё выданное больше не нужно; если блоков было несколько, они заменяются одним общим
+    void reset() {
+        if (blocks_.size() > 1) {
+            size_t total = capacity();
+            blocks_.clear();
+            add_block(total);
+        }
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    // подготовить хотя бы bytes байт одним блоком (вызывать после reset, до первых allocate)
+    void reserve(size_t bytes) {
+        if (capacity() < bytes) {
+            blocks_.clear();
+            add_block(bytes);
+            current_ = 0;
+            offset_ = 0;
+        }
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& b : blocks_) {
+            total += b.size;
+        }
+        return total;
+    }
+
+    // сколько байт выдано с последнего reset (вместе с выравниванием)
+    size_t used() const {
+        return used_;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::max_align_t[]> data;
+        size_t size;
+    };
+
+    void add_block(size_t bytes) {
+        size_t words = (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        blocks_.push_back({ std::unique_ptr<std::max_align_t[]>(new std::max_align_t[words]),
+                            words * sizeof(std::max_align_t) });
+    }
+
+    void* allocate_bytes(size_t bytes, size_t align) {
+        for (;;) {
+            if (current_ < blocks_.size()) {
+                size_t at = (offset_ + align - 1) / align * align;
+                if (at + bytes <= blocks_[current_].size) {
+                    used_ += at + bytes - offset_;
+                    offset_ = at + bytes;
+                    return reinterpret_cast<char*>(blocks_[current_].data.get()) + at;
+                }
+                if (current_ + 1 < blocks_.size()) {
+                    current_++;
+                    offset_ = 0;
+                    continue;
+                }
+            }
+            next_block_ = std::max(next_block_, bytes + align);
+            add_block(next_block_);
+            next_block_ *= 2;
+            current_ = blocks_.size() - 1;
+            offset_ = 0;
+        }
+    }
+
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+    size_t offset_ = 0;
+    size_t used_ = 0;
+    size_t next_block_;
+};
@@ -0,0 +1,380 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include "mesh.hpp"
+#include "point_io.hpp"
+
+
+// Двоичный формат точек и рёбер (little-endian), версия 1:
+//   заголовок (64 байта, BinaryHeader);
+//   points_offset: xs[n], затем ys[n] - float64 или int32, в зависимости от coord_type;
+//   edges_offset: пары номеров точек uint32 [m][2];
+//   verification_offset (0 - блока нет): признаки verification, по биту на ребро.
+// Блоки выровнены по 64 байтам, поэтому после mmap массивы читаются на месте, без копирования.
+namespace binary_format {
+
+const char kMagic[4] = { 'G', 'T', 'R', 'I' };
+const uint16_t kVersion = 1;
+const uint64_t kAlign = 64;
+
+enum class CoordType : uint16_t {
+    float64 = 0,
+    int32 = 1
+};
+
+struct BinaryHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t coord_type;
+    uint64_t point_count;
+    uint64_t edge_count;
+    uint64_t points_offset;
+    uint64_t edges_offset;
+    uint64_t verification_offset;
+    uint64_t reserved[2];
+};
+static_assert(sizeof(BinaryHeader) == 64, "binary header must stay 64 bytes");
+
+inline uint64_t align_up(uint64_t v) {
+    return (v + kAlign - 1) / kAlign * kAlign;
+}
+
+inline size_t coord_size(CoordType type) {
+    return type == CoordType::int32 ? sizeof(int32_t) : sizeof(double);
+}
+
+inline void check_host() {
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const unsigned char*>(&probe) != 1) {
+        throw std::runtime_error("binary format: big-endian hosts are not supported");
+    }
+}
+
+// начинается ли файл с подписи формата
+inline bool is_binary(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    in.read(magic, 4);
+    return in.gcount() == 4 && std::memcmp(magic, kMagic, 4) == 0;
+}
+
+// все ли координаты - целые в пределах int32 (тогда их можно хранить как int32 без потерь)
+inline bool fits_int32(const PointSet& points) {
+    for (size_t i = 0; i < points.size(); i++) {
+        for (double v : { points.xs[i], points.ys[i] }) {
+            if (!(v >= INT32_MIN && v <= INT32_MAX) || std::floor(v) != v) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+// Запись: заголовок и точки - сразу, рёбра - по одному (можно передавать как sink в triangulate_fast_stream),
+// признаки verification (если есть) и итоговый заголовок - в finish().
+class BinaryWriter {
+public:
+    BinaryWriter(const std::string& path, const PointSet& points, CoordType type = CoordType::float64)
+        : out_(path, std::ios::binary | std::ios::trunc) {
+        check_host();
+        if (!out_.is_open()) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        if (type == CoordType::int32 && !fits_int32(points)) {
+            throw std::runtime_error("binary format: coordinates are not int32");
+        }
+        std::memset(&header_, 0, sizeof(header_));
+        std::memcpy(header_.magic, kMagic, 4);
+        header_.version = kVersion;
+        header_.coord_type = uint16_t(type);
+        header_.point_count = points.size();
+        header_.points_offset = align_up(sizeof(BinaryHeader));
+        header_.edges_offset = align_up(header_.points_offset + 2 * points.size() * coord_size(type));
+
+        out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        pad(header_.points_offset);
+        if (type == CoordType::int32) {
+            std::vector<int32_t> buffer(points.size());
+            for (const std::vector<double>* coords : { &points.xs, &points.ys }) {
+                for (size_t i = 0; i < points.size(); i++) {
+                    buffer[i] = int32_t((*coords)[i]);
+                }
+                write(buffer.data(), buffer.size());
+            }
+        }
+        else {
+            write(points.xs.data(), points.size());
+            write(points.ys.data(), points.size());
+        }
+        pad(header_.edges_offset);
+    }
+
+    ~BinaryWriter() {
+        if (!finished_) {
+            try {
+                finish();
+            }
+            catch (...) {
+            }
+        }
+    }
+
+    BinaryWriter(const BinaryWriter&) = delete;
+    BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+    void operator()(uint32_t i, uint32_t j) {
+        push_back(i, j);
+    }
+
+    void push_back(uint32_t i, uint32_t j) {
+        if (has_bits_) {
+            push_back(i, j, true);
+            return;
+        }
+        append(i, j);
+    }
+
+    // то же с признаком verification; если он передан хоть раз, блок признаков пишется для всех рёбер
+    // (рёбра, записанные без признака, считаются принятыми)
+    void push_back(uint32_t i, uint32_t j, bool ok) {
+        if (!has_bits_) {
+            bits_.assign(size_t(header_.edge_count / 8) + 1, 0);
+            for (uint64_t k = 0; k < header_.edge_count; k++) {
+                bits_[k / 8] |= uint8_t(1u << (k % 8));
+            }
+            has_bits_ = true;
+        }
+        bits_.resize(size_t(header_.edge_count / 8) + 1, 0);
+        if (ok) {
+            bits_[header_.edge_count / 8] |= uint8_t(1u << (header_.edge_count % 8));
+        }
+        append(i, j);
+    }
+
+    void finish() {
+        finished_ = true;
+        if (has_bits_) {
+            header_.verification_offset = align_up(header_.edges_offset + 2 * sizeof(uint32_t) * header_.edge_count);
+            pad(header_.verification_offset);
+            bits_.resize(size_t((header_.edge_count + 7) / 8), 0);
+            write(bits_.data(), bits_.size());
+        }
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("binary format: write failed");
+        }
+    }
+
+private:
+    void append(uint32_t i, uint32_t j) {
+        uint32_t pair[2] = { i, j };
+        write(pair, 2);
+        header_.edge_count++;
+    }
+
+    template <class T>
+    void write(const T* data, size_t count) {
+        out_.write(reinterpret_cast<const char*>(data), std::streamsize(count * sizeof(T)));
+        at_ += count * sizeof(T);
+    }
+
+    void pad(uint64_t offset) {
+        static const char zeros[kAlign] = {};
+        out_.write(zeros, std::streamsize(offset - at_));
+        at_ = offset;
+    }
+
+    std::ofstream out_;
+    BinaryHeader header_;
+    uint64_t at_ = sizeof(BinaryHeader);
+    std::vector<uint8_t> bits_;
+    bool has_bits_ = false;
+    bool finished_ = false;
+};
+
+inline void write_binary(const std::string& path, const PointSet& points, CoordType type = CoordType::float64) {
+    BinaryWriter(path, points, type).finish();
+}
+
+// сетка целиком: все рёбра вместе с признаками verification
+inline void write_binary(const std::string& path, const Mesh& mesh, CoordType type = CoordType::float64) {
+    BinaryWriter writer(path, mesh.points, type);
+    for (size_t k = 0; k < mesh.edges.size(); k++) {
+        writer.push_back(mesh.edges.a[k], mesh.edges.b[k], mesh.edges.verification[k]);
+    }
+    writer.finish();
+}
+
+
+// Файл формата, открытый через mmap: массивы читаются прямо из отображения, без разбора и копирования.
+// Где mmap нет, файл один раз читается в память целиком.
+class MappedMesh {
+public:
+    explicit MappedMesh(const std::string& path) {
+        check_host();
+        file_.reset(new MappedFile(path));
+        if (file_->mapped()) {
+            data_ = file_->data();
+            size_ = file_->size();
+        }
+        else {
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            if (!in.is_open()) {
+                throw std::runtime_error("cannot open " + path);
+            }
+            size_ = size_t(in.tellg());
+            copy_.resize((size_ + sizeof(double) - 1) / sizeof(double));
+            in.seekg(0);
+            in.read(reinterpret_cast<char*>(copy_.data()), std::streamsize(size_));
+            data_ = reinterpret_cast<const char*>(copy_.data());
+        }
+        validate(path);
+    }
+
+    const BinaryHeader& header() const {
+        return header_;
+    }
+
+    CoordType coord_type() const {
+        return CoordType(header_.coord_type);
+    }
+
+    size_t point_count() const {
+        return size_t(header_.point_count);
+    }
+
+    size_t edge_count() const {
+        return size_t(header_.edge_count);
+    }
+
+    bool has_verification() const {
+        return header_.verification_offset != 0;
+    }
+
+    // координаты float64 (только для coord_type() == float64)
+    const double* xs() const {
+        return reinterpret_cast<const double*>(data_ + header_.points_offset);
+    }
+
+    const double* ys() const {
+        return xs() + point_count();
+    }
+
+    // координаты int32 (только для coord_type() == int32)
+    const int32_t* xs_int() const {
+        return reinterpret_cast<const int32_t*>(data_ + header_.points_offset);
+    }
+
+    const int32_t* ys_int() const {
+        return xs_int() + point_count();
+    }
+
+    double x(size_t i) const {
+        return coord_type() == CoordType::int32 ? double(xs_int()[i]) : xs()[i];
+    }
+
+    double y(size_t i) const {
+        return coord_type() == CoordType::int32 ? double(ys_int()[i]) : ys()[i];
+    }
+
+    // рёбра парами: edges()[2k], edges()[2k + 1]
+    const uint32_t* edges() const {
+        return reinterpret_cast<const uint32_t*>(data_ + header_.edges_offset);
+    }
+
+    bool verification(size_t k) const {
+        if (!has_verification()) {
+            return true;
+        }
+        const uint8_t* bits = reinterpret_cast<const uint8_t*>(data_ + header_.verification_offset);
+        return (bits[k / 8] >> (k % 8)) & 1;
+    }
+
+    // копия в PointSet (для алгоритмов, которые работают с ним); float64 - два memcpy
+    PointSet points() const {
+        PointSet result;
+        size_t n = point_count();
+        if (coord_type() == CoordType::float64) {
+            result.xs.assign(xs(), xs() + n);
+            result.ys.assign(ys(), ys() + n);
+        }
+        else {
+            result.xs.assign(xs_int(), xs_int() + n);
+            result.ys.assign(ys_int(), ys_int() + n);
+        }
+        return result;
+    }
+
+    Mesh mesh() const {
+        Mesh result;
+        result.points = points();
+        result.edges.reserve(edge_count());
+        for (size_t k = 0; k < edge_count(); k++) {
+            result.edges.push_back(edges()[2 * k], edges()[2 * k + 1], verification(k));
+        }
+        return result;
+    }
+
+private:
+    void validate(const std::string& path) {
+        if (size_ < sizeof(BinaryHeader)) {
+            throw std::runtime_error(path + ": not a binary point file");
+        }
+        std::memcpy(&header_, data_, sizeof(header_));
+        if (std::memcmp(header_.magic, kMagic, 4) != 0) {
+            throw std::runtime_error(path + ": not a binary point file");
+        }
+        if (header_.version != kVersion) {
+            throw std::runtime_error(path + ": unsupported binary format version " + std::to_string(header_.version));
+        }
+        if (header_.coord_type > uint16_t(CoordType::int32)) {
+            throw std::runtime_error(path + ": unknown coordinate type");
+        }
+        // размеры проверяются делением, чтобы испорченный заголовок не дал переполнения
+        size_t csize = coord_size(coord_type());
+        bool ok = header_.points_offset % kAlign == 0 && header_.edges_offset % kAlign == 0 &&
+                  header_.verification_offset % kAlign == 0 &&
+                  header_.points_offset <= size_ && header_.edges_offset <= size_ &&
+                  header_.point_count <= (size_ - header_.points_offset) / (2 * csize) &&
+                  header_.edge_count <= (size_ - header_.edges_offset) / (2 * sizeof(uint32_t));
+        if (ok && has_verification()) {
+            ok = header_.verification_offset <= size_ &&
+                 (header_.edge_count + 7) / 8 <= size_ - header_.verification_offset;
+        }
+        if (!ok) {
+            throw std::runtime_error(path + ": corrupt binary point file");
+        }
+        for (size_t k = 0; k < 2 * edge_count(); k++) {
+            if (edges()[k] >= header_.point_count) {
+                throw std::runtime_error(path + ": edge refers to a missing point");
+            }
+        }
+    }
+
+    std::unique_ptr<MappedFile> file_;
+    std::vector<double> copy_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    BinaryHeader header_;
+};
+
+}
+
+
+// точки из файла любого формата: двоичный узнаётся по подписи, иначе - текст "n x y ..."
+inline PointSet load_points(const std::string& path) {
+    if (binary_format::is_binary(path)) {
+        return binary_format::MappedMesh(path).points();
+    }
+    return read_points(path);
+}
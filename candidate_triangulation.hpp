@@ -0,0 +1,290 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "segment_index.hpp"
+#include "edge_sort.hpp"
+#include "triangulate.hpp"
+#include "delaunay.hpp"
+
+
+// откуда брать кандидатов для жадного прохода
+struct CandidateOptions {
+    bool delaunay = true;        // рёбра триангуляции Делоне
+    size_t neighbours = 0;       // пары с k ближайшими соседями каждой точки (0 - без них)
+    bool validate = true;        // доказывать результат на каждом запуске, недостающие пары добирать
+    CrossingRule rule = CrossingRule::robust;
+};
+
+// отчёт о кандидатах и проверке
+struct CandidateReport {
+    size_t candidates = 0;       // кандидатов в последнем проходе (без повторов)
+    size_t added = 0;            // пар, которых не было среди кандидатов и которые добавила проверка
+    size_t checked = 0;          // пар, проверенных на пересечение с более ранними рёбрами
+    size_t rounds = 0;           // жадных проходов
+    bool proven = false;         // проверка прошла и доказывает, что рёбра те же, что у triangulate() (только robust)
+    double candidate_seconds = 0;
+    double greedy_seconds = 0;
+    double validate_seconds = 0;
+};
+
+
+namespace candidate_detail {
+
+// k ближайших соседей каждой точки (без неё самой): f(p, q) на каждую пару, q - сосед p
+template <class F>
+void nearest_neighbours(const PointSet& points, const UniformGrid& grid, const greedy_detail::PointBuckets& buckets,
+                        size_t k, F&& f) {
+    const uint32_t n = uint32_t(points.size());
+    k = std::min<size_t>(k, n - 1);
+    if (k == 0) {
+        return;
+    }
+    std::vector<std::pair<double, uint32_t>> near;
+    for (uint32_t p = 0; p < n; p++) {
+        double px = points.xs[p], py = points.ys[p];
+        // в квадрате со стороной 2 reach есть все точки ближе reach; набралось k таких - ответ среди них
+        for (double reach = grid.cell;; reach *= 2) {
+            near.clear();
+            for (int r = grid.row(py - reach); r <= grid.row(py + reach); r++) {
+                for (int c = grid.col(px - reach); c <= grid.col(px + reach); c++) {
+                    int cell = grid.index(c, r);
+                    for (uint32_t m = buckets.start[cell]; m < buckets.start[cell + 1]; m++) {
+                        uint32_t q = buckets.items[m];
+                        double len = points.length(p, q);
+                        if (q != p && len <= reach) {
+                            near.push_back({ len, q });
+                        }
+                    }
+                }
+            }
+            if (near.size() >= k || reach > grid.diagonal()) {
+                break;
+            }
+        }
+        std::nth_element(near.begin(), near.begin() + (k - 1), near.end());
+        for (size_t m = 0; m < k && m < near.size(); m++) {
+            f(p, near[m].second);
+        }
+    }
+}
+
+}
+
+
+// Жадная триангуляция по небольшому набору кандидатов вместо всех n(n - 1)/2 пар.
+// Кандидаты - рёбра триангуляции Делоне и/или пары с k ближайшими соседями, их O(n). Жадный проход
+// тот же, что у triangulate(): по порядку (длина, номера), ребро принимается, если не пересекает принятых.
+// Жадная триангуляция не обязана лежать внутри кандидатов, поэтому результат проверяется
+// (validate; характеристика жадного результата: пара не принята тогда и только тогда, когда её пересекает
+// более раннее принятое ребро). Пара, которой нет среди рёбер, должна пересекать более раннее ребро;
+// перебираются только пары короче радиусов веера обоих концов (greedy_detail::fan_radius), остальные
+// закрыты заведомо. Найденные пары добавляются к кандидатам, и проход повторяется, пока проверка не пройдёт.
+// Итог совпадает с triangulate() (точно - для CrossingRule::robust; для legacy - при точках в общем
+// положении, как и у triangulate_fast_stream, поэтому с legacy report.proven не ставится). Без validate -
+// один проход без гарантии.
+// Память O(n): кандидаты, сетка точек, индекс принятых рёбер и списки соседей.
+// Возвращает принятые рёбра в порядке принятия; report (если задан) - размеры и время этапов.
+inline EdgeList triangulate_candidates_mesh(const PointSet& points, const CandidateOptions& options = CandidateOptions(),
+                                            CandidateReport* report = nullptr) {
+    using clock = std::chrono::steady_clock;
+    CandidateReport local;
+    CandidateReport& stats = report ? *report : local;
+    stats = CandidateReport();
+
+    EdgeList result;
+    const uint32_t n = uint32_t(points.size());
+    if (n < 2) {
+        stats.proven = true;
+        return result;
+    }
+
+    auto start = clock::now();
+    UniformGrid grid(points, 2.0);
+    greedy_detail::PointBuckets buckets(grid, points);
+    std::vector<CandidateEdge> candidates;
+    auto add = [&](uint32_t i, uint32_t j) {
+        uint32_t a = std::min(i, j), b = std::max(i, j);
+        candidates.push_back({ points.length(a, b), a, b });
+    };
+    if (options.delaunay) {
+        EdgeList edges = triangulate_delaunay(points);
+        candidates.reserve(edges.size() + options.neighbours * n);
+        for (size_t k = 0; k < edges.size(); k++) {
+            add(edges.a[k], edges.b[k]);
+        }
+    }
+    candidate_detail::nearest_neighbours(points, grid, buckets, options.neighbours, add);
+    stats.candidate_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::vector<uint32_t> hull_prev, hull_next;
+    if (options.validate) {
+        hull_prev.assign(n, greedy_detail::kNone);
+        hull_next.assign(n, greedy_detail::kNone);
+        greedy_detail::hull_links(points, grid, buckets, hull_prev, hull_next);
+    }
+
+    SegmentIndex accepted;
+    std::vector<uint32_t> taken;              // номер в candidates для каждого принятого
+    std::vector<std::vector<uint32_t>> adj(options.validate ? n : 0);
+    std::vector<std::pair<double, uint32_t>> around;
+    std::vector<double> radius;
+    std::vector<uint32_t> open;
+    std::vector<CandidateEdge> extra;
+    for (;;) {
+        stats.rounds++;
+        start = clock::now();
+        {
+            STATS_STAGE("candidate_greedy");
+            sort_candidates(candidates, 1);
+            candidates.erase(std::unique(candidates.begin(), candidates.end(),
+                [](const CandidateEdge& a, const CandidateEdge& b) { return a.i == b.i && a.j == b.j; }),
+                candidates.end());
+            if (stats.rounds > 1) {
+                stats.added += candidates.size() - stats.candidates;
+            }
+            stats.candidates = candidates.size();
+
+            // принятые рёбра ложатся в индекс в порядке принятия: номер в индексе - номер в taken
+            accepted.reset(grid, options.rule);
+            accepted.reserve(3 * size_t(n));
+            taken.clear();
+            for (uint32_t k = 0; k < candidates.size(); k++) {
+                Point A = points[candidates[k].i];
+                Point B = points[candidates[k].j];
+                if (!accepted.crosses_any(A, B)) {
+                    accepted.insert(A, B);
+                    taken.push_back(k);
+                }
+            }
+        }
+        stats.greedy_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        if (!options.validate) {
+            break;
+        }
+
+        // пары, которых нет среди рёбер, должны быть закрыты более ранним ребром
+        start = clock::now();
+        STATS_STAGE("candidate_validate");
+        for (std::vector<uint32_t>& list : adj) {
+            list.clear();
+        }
+        for (uint32_t k : taken) {
+            adj[candidates[k].i].push_back(candidates[k].j);
+            adj[candidates[k].j].push_back(candidates[k].i);
+        }
+        for (std::vector<uint32_t>& list : adj) {
+            std::sort(list.begin(), list.end());
+        }
+        auto has_edge = [&](uint32_t a, uint32_t b) {
+            return std::binary_search(adj[a].begin(), adj[a].end(), b);
+        };
+        const double inf = std::numeric_limits<double>::infinity();
+        radius.resize(n);
+        open.clear();
+        for (uint32_t q = 0; q < n; q++) {
+            radius[q] = greedy_detail::fan_radius(points, q, adj[q], has_edge, around, hull_prev[q], hull_next[q]);
+            if (radius[q] == inf) {
+                open.push_back(q);
+            }
+        }
+        // Пару, которой нет среди рёбер и которая короче радиусов обоих концов, должно закрывать более
+        // раннее ребро. Как только нашлась незакрытая, результат не доказан: дальше пары уже не проверяются,
+        // а собираются все (nearby) - иначе недостающие рёбра, закрытые лишними, находились бы по одному за проход.
+        bool proven = true;
+        extra.clear();
+        auto check = [&](uint32_t q, uint32_t r, bool nearby) {
+            uint32_t a = std::min(q, r), b = std::max(q, r);
+            if (has_edge(a, b)) {
+                return;
+            }
+            CandidateEdge e = { points.length(a, b), a, b };
+            if (e.len > std::min(radius[a], radius[b])) {
+                return;
+            }
+            bool open_pair = false;
+            if (proven || !nearby) {
+                stats.checked++;
+                // принятые рёбра лежат в индексе в порядке принятия: номера до before - более ранние
+                uint32_t before = uint32_t(std::lower_bound(taken.begin(), taken.end(), e,
+                    [&](uint32_t k, const CandidateEdge& x) { return candidate_less(candidates[k], x); }) - taken.begin());
+                open_pair = !accepted.crosses_any(points[a], points[b], 0, before);
+                proven = proven && !open_pair;
+            }
+            if (nearby || open_pair) {
+                extra.push_back(e);
+            }
+        };
+        // пары q с точками в квадрате со стороной 2 reach
+        auto scan = [&](uint32_t q, double reach, bool open_only) {
+            double px = points.xs[q], py = points.ys[q];
+            for (int r = grid.row(py - reach); r <= grid.row(py + reach); r++) {
+                for (int c = grid.col(px - reach); c <= grid.col(px + reach); c++) {
+                    int cell = grid.index(c, r);
+                    for (uint32_t k = buckets.start[cell]; k < buckets.start[cell + 1]; k++) {
+                        uint32_t x = buckets.items[k];
+                        // пару двух закрытых точек берём один раз, с незакрытой - отсюда
+                        bool take = open_only ? radius[x] == inf : radius[x] == inf || x > q;
+                        if (x != q && take) {
+                            check(q, x, true);
+                        }
+                    }
+                }
+            }
+        };
+        for (uint32_t q = 0; q < n; q++) {
+            if (radius[q] != inf) {
+                scan(q, radius[q], false);
+            }
+        }
+        // У незакрытой точки не хватает рёбер, а все пары незакрытых точек - это квадрат их числа.
+        // Сначала берутся пары рядом с ней; полный перебор нужен, только если без него результат доказан.
+        for (uint32_t q : open) {
+            double reach = grid.cell;
+            for (uint32_t x : adj[q]) {
+                reach = std::max(reach, 2 * points.length(q, x));
+            }
+            scan(q, reach, true);
+        }
+        if (proven) {
+            extra.clear();
+            for (size_t a = 0; a < open.size(); a++) {
+                for (size_t b = a + 1; b < open.size(); b++) {
+                    check(open[a], open[b], false);
+                }
+            }
+        }
+        stats.validate_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        if (proven) {
+            // радиусы вееров верны только для точной проверки: с legacy проход просто сходится
+            stats.proven = options.rule == CrossingRule::robust;
+            break;
+        }
+        // пару двух незакрытых точек могли взять с обеих сторон (с кандидатами их сольёт следующий проход)
+        std::sort(extra.begin(), extra.end(), candidate_less);
+        extra.erase(std::unique(extra.begin(), extra.end(),
+            [](const CandidateEdge& a, const CandidateEdge& b) { return a.i == b.i && a.j == b.j; }),
+            extra.end());
+        candidates.insert(candidates.end(), extra.begin(), extra.end());
+    }
+
+    result.reserve(taken.size());
+    for (uint32_t k : taken) {
+        result.push_back(candidates[k].i, candidates[k].j);
+    }
+    return result;
+}
+
+inline std::vector<Edge> triangulate_candidates(const std::vector<Point>& points,
+                                                const CandidateOptions& options = CandidateOptions()) {
+    Mesh mesh;
+    mesh.points = PointSet(points);
+    mesh.edges = triangulate_candidates_mesh(mesh.points, options);
+    return mesh.to_edges();
+}
@@ -1,319 +1,449 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
-#include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/imgproc.hpp> 
+#include <cstdlib>
+#include <string>
 #include<chrono>
 #include<fstream>
-
-
-struct Point {
-    double x_ = 0;
-    double y_ = 0;
-
-    //int x_ = 0;
-    //int y_ = 0;
-
-    Point() = default;
-    ~Point() = default;
-
-    Point(const Point& other) = default;
-    Point& operator=(const Point& other) = default;
-
-    Point(Point&& other) = default;
-    Point& operator=(Point&& other) = default;
-
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "point_io.hpp"
+#include "edge_writer.hpp"
+#include "binary_format.hpp"
+#include "tikz_output.hpp"
+#include "tikz_shards.hpp"
+#include "tiled_triangulation.hpp"
+#include "triangulator.hpp"
+#include "candidate_triangulation.hpp"
+#include "lazy_triangulation.hpp"
+#include "instrumentation.hpp"
+//без OpenCV (-DCOURSEWORK_NO_OPENCV) программа собирается и работает только в режиме --headless
+#ifndef COURSEWORK_NO_OPENCV
+#include "render.hpp"
+#endif
+
+
+//параметры запуска
+struct Options {
+    std::string points = "../../../points.txt";
+    std::string edges;               //куда писать принятые рёбра: текст, *.gtri или "-" (stdout)
+    bool headless = false;           //только расчёт и вывод, без окна и LaTeX
+    bool show = true;
+    int delay_ms = 1000;
+    std::string frames_dir;
+    std::string video;               //шаги в видеофайл (без окна, кадры рисуются параллельно)
+    double fps = 25;
+    std::string tikz = "visualization.txt";
+    TikzOptions tikz_steps;
+    ShardOptions shards;             //--shards: LaTeX кусками, компиляция параллельно и с кэшем
+    bool sharded = false;
+    unsigned threads = 0;
+    bool all_pairs = false;          //визуализация: все n(n - 1)/2 пар, а не только проверенные до полной триангуляции
+    CrossingRule rule = CrossingRule::legacy;
+    size_t tiles = 0;                //--headless: триангуляция по плиткам (0 - одним куском)
+    Engine engine = Engine::greedy;  //--headless: каким алгоритмом триангулировать
+    std::string candidates;          //--headless: жадный проход только по кандидатам (delaunay, knn, both)
+    size_t knn = 8;                  //ближайших соседей на точку для knn и both
+    bool validate = true;            //проверять, что результат по кандидатам совпадает с полным перебором
+    std::string stats;               //JSON со счётчиками и временем этапов
+    std::string trace;               //события для chrome://tracing
 };
 
+void usage() {
+    std::cout << "usage: course_work_v4 [points] [edges] [options]\n"
+        "  points          points file, text or .gtri (default ../../../points.txt)\n"
+        "  edges           write accepted edges: text \"i j\" lines, .gtri, or - for stdout\n"
+        "  --headless      compute and emit results only: no window, no LaTeX\n"
+        "  --delay MS      pause between frames in the window, 0 - no pause (default 1000)\n"
+        "  --frames DIR    save every frame to DIR as PNG (no window needed; rendered in parallel, no delay)\n"
+        "  --video FILE    save every frame to a video: .avi (MJPG) or .mp4 (mp4v)\n"
+        "  --fps N         frames per second for --video (default 25)\n"
+        "  --no-window     do not open the window\n"
+        "  --tikz FILE     LaTeX output (default visualization.txt; off in --headless)\n"
+        "  --tikz-every N  draw only every N-th step in LaTeX (0 - final result only)\n"
+        "  --tikz-steps S  which steps to draw in LaTeX: all, accepted, rejected, none\n"
+        "  --shards N      split LaTeX into standalone files of N step pictures each (instead of --tikz FILE),\n"
+        "                  compile them in parallel and merge into one PDF; unchanged files are not recompiled\n"
+        "  --shard-dir DIR where the files, their PDFs and the cache live (default tikz_shards)\n"
+        "  --latex-jobs N  LaTeX compilations at once (0 - all cores, default)\n"
+        "  --pdf FILE      merged PDF (default visualization.pdf)\n"
+        "  --threads N     threads for sorting candidates (--all-pairs), tiles and frames (0 - all cores)\n"
+        "  --all-pairs     with --robust: window/frames/LaTeX show every pair of points, including the long\n"
+        "                  ones rejected after the triangulation is complete (all pairs are kept in memory);\n"
+        "                  without --robust every pair is always shown\n"
+        "  --robust        exact predicates instead of the legacy crossing test; --headless then runs the\n"
+        "                  fast engine (memory O(n)), without it all pairs are checked as in the window\n"
+        "  --tiles N       with --headless and --robust: split into N tiles, triangulate them in parallel\n"
+        "                  and stitch; prints per-tile points, memory and time\n"
+        "  --engine E      with --headless: greedy (default), delaunay or sweep; delaunay and sweep are\n"
+        "                  much faster but do not give the greedy (shortest-edges-first) triangulation\n"
+        "  --candidates S  with --headless: greedy over a small candidate set instead of all pairs:\n"
+        "                  delaunay (Delaunay edges), knn (K nearest neighbours) or both; the result is\n"
+        "                  checked and missing pairs are added until it provably matches the full greedy\n"
+        "  --knn K         neighbours per point for --candidates knn/both (default 8)\n"
+        "  --no-validate   with --candidates: a single pass, no proof that the result is the greedy one\n"
+        "  --stats FILE    write counters, stage times and peak memory as JSON\n"
+        "  --trace FILE    write stages as a Chrome trace-event file (chrome://tracing, Perfetto)\n"
+        "                  (--stats and --trace need a build with -DTRIANGULATION_STATS)\n";
+}
 
-struct Edge {
-    Point A_;
-    Point B_;
-
-    bool verification = true;
-
-    Edge() = default;
-    ~Edge() = default;
-
-    Edge(const Edge& other) = default;
-    Edge& operator=(const Edge& other) = default;
-
-    Edge(Edge&& other) = default;
-    Edge& operator=(Edge&& other) = default;
-
-    Edge(Point A, Point B) {
-        A_ = A;
-        B_ = B;
-    }
-
-    double length() {
-        return sqrt(pow(A_.x_ - B_.x_, 2) + pow(A_.y_ - B_.y_, 2));
-    }
-
-    //метод проверки на пересечение с другим отрезком на основе векторного прооизведения
-    bool crosses(Edge rhs) {
-        Point crossing;
-        double d = (A_.x_ - B_.x_) * (rhs.B_.y_ - rhs.A_.y_) - (A_.y_ - B_.y_) * (rhs.B_.x_ - rhs.A_.x_);
-        if (d == 0) {
-            return false;
+//разбор аргументов; false - ошибка в аргументах
+bool parse_options(int argc, char** argv, Options& options) {
+    bool tikz_set = false;
+    bool window_set = false;
+    int positional = 0;
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = k + 1 < argc;
+        if (arg == "--headless") {
+            options.headless = true;
+        }
+        else if (arg == "--delay" && has_value) {
+            options.delay_ms = std::atoi(argv[++k]);
+        }
+        else if (arg == "--frames" && has_value) {
+            options.frames_dir = argv[++k];
+        }
+        else if (arg == "--video" && has_value) {
+            options.video = argv[++k];
+        }
+        else if (arg == "--fps" && has_value) {
+            options.fps = std::atof(argv[++k]);
+            if (!(options.fps > 0)) {
+                std::cout << "--fps must be positive\n";
+                return false;
+            }
+        }
+        else if (arg == "--no-window") {
+            options.show = false;
+            window_set = true;
+        }
+        else if (arg == "--tikz" && has_value) {
+            options.tikz = argv[++k];
+            tikz_set = true;
+        }
+        else if (arg == "--tikz-every" && has_value) {
+            options.tikz_steps.every = size_t(std::atol(argv[++k]));
+        }
+        else if (arg == "--tikz-steps" && has_value) {
+            std::string steps = argv[++k];
+            if (steps != "all" && steps != "accepted" && steps != "rejected" && steps != "none") {
+                std::cout << "unknown --tikz-steps " << steps << "\n";
+                return false;
+            }
+            options.tikz_steps.accepted_steps = steps == "all" || steps == "accepted";
+            options.tikz_steps.rejected_steps = steps == "all" || steps == "rejected";
         }
-        double ua = ((rhs.A_.x_ - rhs.B_.x_) * (A_.y_ - rhs.A_.y_) - (rhs.A_.y_ - rhs.B_.y_) * (A_.x_ - rhs.A_.x_)) / d;
-        double ub = ((A_.x_ - B_.x_) * (A_.y_ - rhs.A_.y_) - (A_.y_ - B_.y_) * (A_.x_ - rhs.A_.x_)) / d;
-        if (ua < 0 || ua > 1 || ub < 0 || ub > 1) {
+        else if (arg == "--shards" && has_value) {
+            options.shards.pictures = size_t(std::atol(argv[++k]));
+            options.sharded = true;
+        }
+        else if (arg == "--shard-dir" && has_value) {
+            options.shards.dir = argv[++k];
+        }
+        else if (arg == "--latex-jobs" && has_value) {
+            options.shards.jobs = unsigned(std::atoi(argv[++k]));
+        }
+        else if (arg == "--pdf" && has_value) {
+            options.shards.pdf = argv[++k];
+        }
+        else if (arg == "--all-pairs") {
+            options.all_pairs = true;
+        }
+        else if (arg == "--threads" && has_value) {
+            options.threads = unsigned(std::atoi(argv[++k]));
+        }
+        else if (arg == "--tiles" && has_value) {
+            options.tiles = size_t(std::atol(argv[++k]));
+        }
+        else if (arg == "--engine" && has_value) {
+            std::string engine = argv[++k];
+            if (!parse_engine(engine, options.engine)) {
+                std::cout << "unknown --engine " << engine << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--candidates" && has_value) {
+            options.candidates = argv[++k];
+            if (options.candidates != "delaunay" && options.candidates != "knn" && options.candidates != "both") {
+                std::cout << "unknown --candidates " << options.candidates << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--knn" && has_value) {
+            options.knn = size_t(std::atol(argv[++k]));
+        }
+        else if (arg == "--no-validate") {
+            options.validate = false;
+        }
+        else if (arg == "--stats" && has_value) {
+            options.stats = argv[++k];
+        }
+        else if (arg == "--trace" && has_value) {
+            options.trace = argv[++k];
+        }
+        else if (arg == "--robust") {
+            options.rule = CrossingRule::robust;
+        }
+        else if (arg == "--help" || arg == "-h") {
             return false;
         }
-        crossing.x_ = double(A_.x_ + ua * (B_.x_ - A_.x_));
-        crossing.y_ = double(A_.y_ + ua * (B_.y_ - A_.y_));
-        if (crossing.x_ == rhs.A_.x_ && crossing.y_ == rhs.A_.y_ || crossing.x_ == rhs.B_.x_ && crossing.y_ == rhs.B_.y_) {
+        else if (arg.size() > 1 && arg[0] == '-' && arg != "-") {
+            std::cout << "unknown option " << arg << "\n";
             return false;
         }
-        return true;
-    }
-};
-
-
-
-//функция создания триангуляции (списка валидных и невалидных отрезков)
-std::vector<Edge> triangulate(std::vector<Point> points) {
-    std::vector<Edge> edges;
-    std::vector<Edge> result;
-    for (int i = 0; i < points.size() - 1; i++) {
-        for (int j = i + 1; j < points.size(); j++) {
-            edges.push_back(Edge(points[i], points[j]));
+        else if (positional == 0) {
+            options.points = arg;
+            positional++;
         }
-    }
-
-    // Cортируем ребра по длине по возрастанию
-    for (int i = 0; i < edges.size() - 1; i++) {
-        for (int j = 0; j < edges.size() - i - 1; j++) {
-            if (edges[j].length() > edges[j + 1].length()) {
-                // меняем элементы местами
-                Edge box = edges[j];
-                edges[j] = edges[j + 1];
-                edges[j + 1] = box;
-            }
+        else if (positional == 1) {
+            options.edges = arg;
+            positional++;
+        }
+        else {
+            return false;
         }
     }
-
-    //отсортированные рёбра проверяем на пересечение с предыдущими
-    for (int i = 0; i < edges.size(); i++) {
-        for (int j = 0; j < result.size(); j++) {
-            // тут проверить на пересечение со всеми текущими подходящими ребрами, и если вдруг пересекает -> Edge.verification = false;
-            if (edges[i].crosses(result[j])) {
-                edges[i].verification = false;
-            }
+    if (options.headless) {
+        options.show = false;
+        if (!tikz_set) {
+            options.tikz.clear();
         }
-        result.push_back(edges[i]);
     }
-    return result;
-}
-
-void makePreamble(std::ofstream& fout) {
-    fout << R"(\documentclass[a4paper]{article})" << std::endl;
-    fout << R"(\usepackage{pgfplots})" << std::endl;
-    fout << R"(\usepackage{tikz})" << std::endl;
-    fout << R"(\usepackage{tkz-euclide})" << std::endl;
-    fout << R"(\usepackage[english, russian]{babel})" << std::endl;
-    fout << R"(\usepackage[T2A]{fontenc})" << std::endl;
-    fout << R"(\usepackage[utf8]{inputenc})" << std::endl;
-    fout << R"(\usepackage{geometry})" << std::endl;
-    fout << R"(\pgfplotsset{compat = 1.18})" << std::endl;
-    fout << R"(\geometry{top = 20mm})" << std::endl;
-    fout << R"(\geometry{bottom = 25mm})" << std::endl;
-    fout << R"(\geometry{left = 25mm})" << std::endl;
-    fout << R"(\geometry{right = 25mm})" << std::endl;
-    fout << R"(\title{Visualization of the Greedy triangulation algorithm.})" << std::endl;
-    fout << R"(\begin{document})" << std::endl;
-    fout << R"(\maketitle)" << std::endl;
+    //для совместимости: файл рёбер без других ключей - только расчёт, как раньше
+    if (!options.edges.empty() && !tikz_set && !window_set && options.frames_dir.empty() && options.video.empty()) {
+        options.show = false;
+        options.tikz.clear();
+    }
+    return true;
 }
 
-void PointsRedrawing(const std::vector<Point>& points, std::ofstream& fout, const cv::Mat& input_image = cv::Mat()) {
-    if (input_image.empty()) {
-        for (int i = 0; i < points.size(); i++) {
-            fout << R"(\filldraw[black])" << "(" << points[i].x_ / 50 << ","
-                << -(points[i].y_ / 50) << ")" << "circle(2pt);" << std::endl;
-        }
+//запись принятых рёбер; сами рёбра уже посчитаны или отдаются по мере принятия через emit
+template <class Run>
+void write_edges(const std::string& out, const PointSet& points, Run&& run) {
+    //*.gtri - двоичный формат (точки и рёбра), иначе текст "i j" по строке на ребро
+    if (out.size() > 5 && out.compare(out.size() - 5, 5, ".gtri") == 0) {
+        binary_format::BinaryWriter writer(out, points);
+        run(writer);
+        writer.finish();
+    }
+    else if (out == "-") {
+        EdgeWriter writer(std::cout, points);
+        run(writer);
     }
     else {
-        for (int i = 0; i < points.size(); i++) {
-            fout << R"(\filldraw[black])" << "(" << points[i].x_ / 50 << ","
-                << -(points[i].y_ / 50) << ")" << "circle(2pt);" << std::endl;
-            cv::Point centre(static_cast<int>(points[i].x_), static_cast<int>(points[i].y_));
-            cv::circle(input_image, centre, 2, cv::Scalar(255, 255, 255), 4);
-        }
+        EdgeWriter writer(out, points);
+        run(writer);
     }
 }
 
-void LineDrawing(std::ofstream& fout, int& k, std::string color, std::vector<Edge> list = {}) {
-    fout << R"(\draw[ultra thick, )" << color << "](" << list[k].A_.x_ / 50 << ", "
-        << -(list[k].A_.y_ / 50) << ")--" << "("
-        << list[k].B_.x_ / 50 << ", "
-        << -(list[k].B_.y_ / 50) << ");" << std::endl;
-}
-
-
-
-//функция проверяющая видимость окна
-bool isWindowClosed(const std::string& windowName) {
-    return cv::getWindowProperty(windowName, cv::WND_PROP_VISIBLE) < 1;
+//отчёты instrumentation в конце работы
+void write_reports(const Options& options) {
+    if ((!options.stats.empty() || !options.trace.empty()) && !instrumentation::enabled()) {
+        std::cerr << "note: built without -DTRIANGULATION_STATS, reports are empty\n";
+    }
+    if (!options.stats.empty()) {
+        std::ofstream out(options.stats);
+        instrumentation::write_json(out);
+    }
+    if (!options.trace.empty()) {
+        std::ofstream out(options.trace);
+        instrumentation::write_trace(out);
+    }
 }
 
 
-void triangulation(std::vector<Point> input) {
-    //список точек для отрисовки триангуляции
-    std::vector<Point> points = input;
-
-    std::ofstream fout; // Создание файла, запись кода LaTex и визуализация
-    fout.open("visualization.txt", std::ofstream::out | std::ofstream::trunc);
-    makePreamble(fout);
-    // переменная для определения границ изображения
-    bool closed = false;
-    fout << R"(\section{Points layout})" << std::endl;
-    fout << R"(\begin{tikzpicture})" << std::endl;
-
-
-    //создаём список всех возмоных отрезков с указанием, пересекают ли они соседние
-    std::vector<Edge> result = triangulate(points);
-
-    //список уже отрисованных отрезков
-    std::vector<Edge> drawen;
-
-    cv::Mat image_green(800, 1450, CV_8UC3, cv::Scalar(0, 0, 0));
-    cv::Mat image_red(800, 1450, CV_8UC3, cv::Scalar(0, 0, 0));
-
-
-    //отрисовываем исходные точки
-    for (int i = 0; i < points.size(); i++) {
-        cv::Point centre(static_cast<int>(points[i].x_), static_cast<int>(points[i].y_));
-        //cv::Point centre(points[i].x_, points[i].y_);
-        cv::circle(image_green, centre, 2, cv::Scalar(255, 255, 255), 4);
-        fout << R"(\filldraw[red])" << "(" << points[i].x_ / 50 << ","
-            << -(points[i].y_ / 50) << ")" << "circle(4pt);" << std::endl;
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+#ifdef COURSEWORK_NO_OPENCV
+    if (options.show || !options.frames_dir.empty() || !options.video.empty()) {
+        std::cerr << "error: built without OpenCV, use --headless (and --tikz for LaTeX)\n";
+        return 2;
+    }
+#endif
+    //шаги с отклонёнными рёбрами и плитки есть только у жадного алгоритма
+    bool visual = options.show || !options.frames_dir.empty() || !options.video.empty() || !options.tikz.empty();
+    if (options.engine != Engine::greedy && (visual || options.tiles != 0)) {
+        std::cerr << "error: --engine " << engine_name(options.engine) << " works only with --headless and without --tiles\n";
+        return 2;
+    }
+    if (!options.candidates.empty() && (visual || options.tiles != 0 || options.engine != Engine::greedy)) {
+        std::cerr << "error: --candidates works only with --headless greedy, without --tiles\n";
+        return 2;
+    }
+    if (options.tiles != 0 && options.rule != CrossingRule::robust) {
+        std::cerr << "error: --tiles needs --robust (the stitch is exact only with exact predicates)\n";
+        return 2;
     }
-    fout << R"(\end{tikzpicture})" << std::endl;
-    closed = true;
-
-    //Создаём окно для работы
-    cv::namedWindow("Display window", cv::WINDOW_AUTOSIZE);
-
-    //флаг показывающий заврешилась ли программа штатно и нужно ли выводить итоговый результат
-    bool finished = true;
-
-    for (int i = 0; i < result.size(); i++) {
-        if (result[i].verification == true) {
-            cv::Point point1(static_cast<int>(result[i].A_.x_), static_cast<int>(result[i].A_.y_));
-            cv::Point point2(static_cast<int>(result[i].B_.x_), static_cast<int>(result[i].B_.y_));
-            //line(image_green, cv::Point(result[i].A_.x_, result[i].A_.y_), cv::Point(result[i].B_.x_, result[i].B_.y_), cv::Scalar(0, 255, 255), 4);
-            line(image_green, point1, point2, cv::Scalar(0, 255, 255), 4);
-
-            if (closed) {
-                fout << R"(\section{ood edges})" << std::endl;
-                fout << R"(\begin{tikzpicture})" << std::endl;
-                closed = false;
-                PointsRedrawing(points, fout);
-            }
 
-            for (int k = 0; k < drawen.size(); k++) {
-                LineDrawing(fout, k, "green", drawen);
+    PointSet points;
+    try {
+        //файл отображается в память (mmap); текстовый разбирается без копирования, двоичный читается как есть
+        STATS_STAGE("load");
+        points = load_points(options.points);
+    }
+    catch (const std::exception& e) { // если файл не открыт или в нём не числа
+        std::cerr << "error: " << e.what() << "\n"; // сообщить об этом
+        return 1;
+    }
+    //при выводе рёбер в stdout сводка уходит в stderr
+    std::ostream& log = options.edges == "-" ? std::cerr : std::cout;
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        if (!visual) {
+            //только принятые рёбра, по мере принятия: весь список кандидатов не нужен
+            size_t count = 0;
+            auto counted = [&](auto& sink) {
+                if (options.engine != Engine::greedy) {
+                    EdgeList edges = make_triangulator(options.engine, options.rule)->triangulate(points);
+                    for (uint32_t k = 0; k < edges.size(); k++) {
+                        sink(edges.a[k], edges.b[k]);
+                    }
+                    count = edges.size();
+                    return;
+                }
+                if (!options.candidates.empty()) {
+                    CandidateOptions source;
+                    source.delaunay = options.candidates != "knn";
+                    source.neighbours = options.candidates != "delaunay" ? options.knn : 0;
+                    source.validate = options.validate;
+                    source.rule = options.rule;
+                    CandidateReport report;
+                    EdgeList edges = triangulate_candidates_mesh(points, source, &report);
+                    for (uint32_t k = 0; k < edges.size(); k++) {
+                        sink(edges.a[k], edges.b[k]);
+                    }
+                    count = edges.size();
+                    log << report.candidates << " candidates (" << report.added << " added by the check), "
+                        << report.rounds << " rounds, " << report.checked << " pairs checked; candidates "
+                        << report.candidate_seconds << " s, greedy " << report.greedy_seconds << " s, check "
+                        << report.validate_seconds << " s; "
+                        << (report.proven ? "same as full greedy" : source.validate ? "not proven" : "not checked")
+                        << "\n";
+                    return;
+                }
+                //быстрый движок и плитки точны только с --robust; с legacy на точках на одной прямой их рёбра
+                //другие, поэтому без --robust - все пары, как triangulate_mesh в окне и LaTeX
+                if (options.rule != CrossingRule::robust) {
+                    EdgeList edges = triangulate_mesh(points, options.threads, options.rule);
+                    for (uint32_t k = 0; k < edges.size(); k++) {
+                        if (edges.verification[k]) {
+                            sink(edges.a[k], edges.b[k]);
+                            count++;
+                        }
+                    }
+                    return;
+                }
+                if (options.tiles == 0) {
+                    triangulate_fast_stream(points, [&](uint32_t i, uint32_t j) { sink(i, j); count++; }, options.rule);
+                    return;
+                }
+                TileOptions tiling;
+                tiling.tiles = options.tiles;
+                tiling.threads = options.threads;
+                tiling.rule = options.rule;
+                TiledReport report;
+                EdgeList edges = triangulate_tiled_mesh(points, tiling, &report);
+                for (uint32_t k = 0; k < edges.size(); k++) {
+                    sink(edges.a[k], edges.b[k]);
+                }
+                count = edges.size();
+                for (size_t t = 0; t < report.tiles.size(); t++) {
+                    const TileStats& tile = report.tiles[t];
+                    log << "tile " << t << ": " << tile.core_points << " points (" << tile.points << " with margin), "
+                        << tile.edges << " edges, " << tile.bytes / 1024 << " KB, " << tile.seconds << " s\n";
+                }
+                log << "tiles " << report.tile_seconds << " s, stitch " << report.stitch_seconds << " s: "
+                    << report.seam << " of " << report.candidates << " edges rechecked, " << report.added
+                    << " added, " << report.rounds << " rounds\n";
+            };
+            if (options.edges.empty()) {
+                auto none = [](uint32_t, uint32_t) {};
+                counted(none);
             }
-
-            LineDrawing(fout, i, "green", result);
-
-            drawen.push_back(result[i]);
-            cv::imshow("Display window", image_green);
-            int k = cv::waitKey(1000);
-            if (k == 27 || isWindowClosed("Display window")) {
-                finished = false;
-                break;
-                cv::destroyAllWindows();
+            else {
+                write_edges(options.edges, points, counted);
             }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            log << points.size() << " points, " << count << " edges, " << seconds << " s\n";
+            write_reports(options);
+            return 0;
         }
-        else {
-            if (!closed) {
-                fout << R"(\end{tikzpicture})" << std::endl;
-                closed = true;
-            }
-            fout << R"(\section{Adding bad edges.})" << std::endl;
-            fout << R"(\begin{tikzpicture})" << std::endl;
-            closed = false;
-
-            cv::Mat image_red(800, 1450, CV_8UC3, cv::Scalar(0, 0, 0));
 
-            PointsRedrawing(points, fout, image_red);
+        //для визуализации нужны кандидаты по порядку, вместе с отклонёнными. С --robust пары берутся лениво
+        //и только до полной триангуляции; ленивый перебор опирается на точную проверку, поэтому с legacy
+        //(и с --all-pairs) - полный список, как у triangulate_mesh
+        Mesh mesh;
+        mesh.points = points;
+        bool lazy = !options.all_pairs && options.rule == CrossingRule::robust;
+        mesh.edges = lazy ? triangulate_lazy_mesh(mesh.points, options.rule)
+                          : triangulate_mesh(mesh.points, options.threads, options.rule);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        log << points.size() << " points, " << mesh.edges.size() << " candidates, " << seconds << " s\n";
+
+        if (!options.edges.empty()) {
+            write_edges(options.edges, mesh.points, [&](auto& sink) {
+                for (uint32_t k = 0; k < mesh.edges.size(); k++) {
+                    if (mesh.edges.verification[k]) {
+                        sink(mesh.edges.a[k], mesh.edges.b[k]);
+                    }
+                }
+            });
+        }
 
-            for (int k = 0; k < drawen.size(); k++) {
-                cv::Point point1(static_cast<int>(drawen[k].A_.x_), static_cast<int>(drawen[k].A_.y_));
-                cv::Point point2(static_cast<int>(drawen[k].B_.x_), static_cast<int>(drawen[k].B_.y_));
-                //line(image_red, cv::Point(drawen[k].A_.x_, drawen[k].A_.y_), cv::Point(drawen[k].B_.x_, drawen[k].B_.y_), cv::Scalar(0, 255, 255), 4);
-                line(image_red,point1 ,point2 , cv::Scalar(0, 255, 255), 4);
-                LineDrawing(fout, k, "green", drawen);
+        if (!options.tikz.empty() && options.sharded) {
+            ShardReport report = build_tikz_pdf(mesh, options.tikz_steps, options.shards);
+            log << report.shards << " LaTeX files: " << report.compiled << " compiled, " << report.cached << " cached, "
+                << report.failed << " failed; write " << report.write_seconds << " s, compile " << report.compile_seconds
+                << " s, merge " << report.merge_seconds << " s\n";
+            if (!report.merged) {
+                std::cerr << "error: " << options.shards.pdf << " not built, see LaTeX logs in " << options.shards.dir << "\n";
             }
-            
-            cv::Point point1(static_cast<int>(result[i].A_.x_), static_cast<int>(result[i].A_.y_));
-            cv::Point point2(static_cast<int>(result[i].B_.x_), static_cast<int>(result[i].B_.y_));
-            //line(image_red, cv::Point(result[i].A_.x_, result[i].A_.y_), cv::Point(result[i].B_.x_, result[i].B_.y_), cv::Scalar(0, 0, 255), 4);
-            line(image_red,point1 , point2, cv::Scalar(0, 0, 255), 4);
-
-            LineDrawing(fout, i, "red", result);
-            fout << R"(\end{tikzpicture})" << std::endl;
-            closed = true;
-
-            cv::imshow("Display window", image_red);
-            int k = cv::waitKey(1000);
-            if (k == 27 || isWindowClosed("Display window")) {
-                finished = false;
-                break;
-                cv::destroyAllWindows();
+        }
+        else if (!options.tikz.empty()) {
+            std::ofstream fout; // Создание файла, запись кода LaTex
+            fout.open(options.tikz, std::ofstream::out | std::ofstream::trunc);
+            if (!fout.is_open()) {
+                throw std::runtime_error("cannot open " + options.tikz);
             }
+            write_tikz(mesh, fout, options.tikz_steps);
         }
-    }
-    if (finished == true) {
-        cv::imshow("Display window", image_green);
-        cv::waitKey(0);
-    }
 
-    fout << R"(\section{Final result.})" << std::endl;
-    fout << R"(\begin{tikzpicture})" << std::endl;
-    PointsRedrawing(points, fout);
-    for (int k = 0; k < drawen.size(); k++) {
-        LineDrawing(fout, k, "green", drawen);
+#ifndef COURSEWORK_NO_OPENCV
+        //файлы кадров - сразу и параллельно, окно - потом, с паузами
+        if (!options.frames_dir.empty() || !options.video.empty()) {
+            RenderOptions render;
+            render.frames_dir = options.frames_dir;
+            render.video = options.video;
+            render.fps = options.fps;
+            render.threads = options.threads;
+            auto begin = std::chrono::steady_clock::now();
+            render_offline(mesh, render);
+            log << mesh.edges.size() << " frames, "
+                << std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() << " s\n";
+        }
+        if (options.show) {
+            RenderOptions render;
+            render.delay_ms = options.delay_ms;
+            render_steps(mesh, render);
+        }
+#endif
     }
-    fout << R"(\end{tikzpicture})" << std::endl;
-    fout << R"(\end{document})" << std::endl;
-
-//    std::system("pdflatex visualisation.tex");
-}
-
-
-int main() {
-    std::string filename = "points.txt";
-    std::ifstream input_file;
-    std::string path = "../../../";
-    input_file.open(path + filename);
-    std::vector<Point> points;
-
-    if (!input_file.is_open()) { // если файл не открыт
-        std::cout << "error\n"; // сообщить об этом
-        exit(1);
+    catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
     }
-    else
-    {
-        int num_points;
-        input_file >> num_points;
-        std::cout << num_points;
 
-        for (int i = 0; i < num_points; i++) {
-            Point p;
-            input_file >> p.x_ >> p.y_;
-            points.push_back(p);
-        }
-        input_file.close();
+    write_reports(options);
+    if (!options.headless && !options.tikz.empty() && !options.sharded) {
+        std::system(("pdflatex -interaction=batchmode \"" + options.tikz + "\"").c_str());
     }
 
-    triangulation(points);
-
-    std::system("pdflatex visualisation.tex");
-
     return 0;
 }
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "geometry.hpp"
+#include "predicates.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CROSSES_SIMD_X86 1
+#endif
+
+
+// Пакетная проверка: пересекает ли отрезок (ax, ay)-(bx, by) отрезки блока (cx[k], cy[k])-(dx[k], dy[k]).
+// Векторная часть - только отбраковка без деления: если по векторным произведениям один отрезок
+// целиком лежит по одну сторону от прямой другого (с большим запасом на погрешность), пересечения нет.
+// Оставшиеся пары проверяются обычным segments_cross по выбранному правилу, поэтому ответ в точности
+// совпадает со скалярной проверкой, в том числе для общих концов (у них векторное произведение 0,
+// и они всегда уходят в точную проверку). Отбраковка верна для обоих правил: разделённые прямой
+// отрезки не пересекаются и не касаются.
+namespace crosses_simd {
+
+// запас отбраковки относительно величины векторного произведения; погрешность double ~1e-16
+const double kTolerance = 1e-12;
+
+struct Query {
+    double ax, ay, bx, by;
+    CrossingRule rule;
+};
+
+// скалярная отбраковка - то же условие, что и в векторных версиях
+inline bool separated(const Query& q, double cx, double cy, double dx, double dy) {
+    double ex = dx - cx, ey = dy - cy;
+    double oa = ex * (q.ay - cy) - ey * (q.ax - cx);
+    double ob = ex * (q.by - cy) - ey * (q.bx - cx);
+    double ta = kTolerance * (fabs(ex) + fabs(ey)) * std::fmax(fabs(q.ax - cx) + fabs(q.ay - cy), fabs(q.bx - cx) + fabs(q.by - cy));
+    if ((oa > ta && ob > ta) || (oa < -ta && ob < -ta)) {
+        return true;
+    }
+    double fx = q.bx - q.ax, fy = q.by - q.ay;
+    double oc = fx * (cy - q.ay) - fy * (cx - q.ax);
+    double od = fx * (dy - q.ay) - fy * (dx - q.ax);
+    double tc = kTolerance * (fabs(fx) + fabs(fy)) * std::fmax(fabs(cx - q.ax) + fabs(cy - q.ay), fabs(dx - q.ax) + fabs(dy - q.ay));
+    return (oc > tc && od > tc) || (oc < -tc && od < -tc);
+}
+
+inline bool exact(const Query& q, double cx, double cy, double dx, double dy) {
+    return segments_cross(q.ax, q.ay, q.bx, q.by, cx, cy, dx, dy, q.rule);
+}
+
+inline size_t first_crossing_scalar(const Query& q, const double* cx, const double* cy,
+                                    const double* dx, const double* dy, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        if (!separated(q, cx[k], cy[k], dx[k], dy[k]) && exact(q, cx[k], cy[k], dx[k], dy[k])) {
+            return k;
+        }
+    }
+    return count;
+}
+
+#ifdef CROSSES_SIMD_X86
+
+// маска "может пересекать" для четырёх отрезков блока
+__attribute__((target("avx2")))
+inline int maybe_mask_avx2(const Query& q, const double* cx, const double* cy, const double* dx, const double* dy) {
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    const __m256d tol = _mm256_set1_pd(kTolerance);
+    const __m256d ax = _mm256_set1_pd(q.ax), ay = _mm256_set1_pd(q.ay);
+    const __m256d bx = _mm256_set1_pd(q.bx), by = _mm256_set1_pd(q.by);
+    __m256d c_x = _mm256_loadu_pd(cx), c_y = _mm256_loadu_pd(cy);
+    __m256d d_x = _mm256_loadu_pd(dx), d_y = _mm256_loadu_pd(dy);
+
+    // где лежат концы кандидата относительно прямой отрезка блока
+    __m256d ex = _mm256_sub_pd(d_x, c_x), ey = _mm256_sub_pd(d_y, c_y);
+    __m256d acx = _mm256_sub_pd(ax, c_x), acy = _mm256_sub_pd(ay, c_y);
+    __m256d bcx = _mm256_sub_pd(bx, c_x), bcy = _mm256_sub_pd(by, c_y);
+    __m256d oa = _mm256_sub_pd(_mm256_mul_pd(ex, acy), _mm256_mul_pd(ey, acx));
+    __m256d ob = _mm256_sub_pd(_mm256_mul_pd(ex, bcy), _mm256_mul_pd(ey, bcx));
+    __m256d len_e = _mm256_add_pd(_mm256_and_pd(ex, abs_mask), _mm256_and_pd(ey, abs_mask));
+    __m256d reach = _mm256_max_pd(_mm256_add_pd(_mm256_and_pd(acx, abs_mask), _mm256_and_pd(acy, abs_mask)),
+                                  _mm256_add_pd(_mm256_and_pd(bcx, abs_mask), _mm256_and_pd(bcy, abs_mask)));
+    __m256d ta = _mm256_mul_pd(tol, _mm256_mul_pd(len_e, reach));
+    __m256d nta = _mm256_sub_pd(_mm256_setzero_pd(), ta);
+    __m256d sep = _mm256_or_pd(
+        _mm256_and_pd(_mm256_cmp_pd(oa, ta, _CMP_GT_OQ), _mm256_cmp_pd(ob, ta, _CMP_GT_OQ)),
+        _mm256_and_pd(_mm256_cmp_pd(oa, nta, _CMP_LT_OQ), _mm256_cmp_pd(ob, nta, _CMP_LT_OQ)));
+
+    // где лежат концы отрезка блока относительно прямой кандидата
+    __m256d fx = _mm256_sub_pd(bx, ax), fy = _mm256_sub_pd(by, ay);
+    __m256d cax = _mm256_sub_pd(c_x, ax), cay = _mm256_sub_pd(c_y, ay);
+    __m256d dax = _mm256_sub_pd(d_x, ax), day = _mm256_sub_pd(d_y, ay);
+    __m256d oc = _mm256_sub_pd(_mm256_mul_pd(fx, cay), _mm256_mul_pd(fy, cax));
+    __m256d od = _mm256_sub_pd(_mm256_mul_pd(fx, day), _mm256_mul_pd(fy, dax));
+    __m256d len_f = _mm256_add_pd(_mm256_and_pd(fx, abs_mask), _mm256_and_pd(fy, abs_mask));
+    reach = _mm256_max_pd(_mm256_add_pd(_mm256_and_pd(cax, abs_mask), _mm256_and_pd(cay, abs_mask)),
+                          _mm256_add_pd(_mm256_and_pd(dax, abs_mask), _mm256_and_pd(day, abs_mask)));
+    __m256d tc = _mm256_mul_pd(tol, _mm256_mul_pd(len_f, reach));
+    __m256d ntc = _mm256_sub_pd(_mm256_setzero_pd(), tc);
+    sep = _mm256_or_pd(sep, _mm256_or_pd(
+        _mm256_and_pd(_mm256_cmp_pd(oc, tc, _CMP_GT_OQ), _mm256_cmp_pd(od, tc, _CMP_GT_OQ)),
+        _mm256_and_pd(_mm256_cmp_pd(oc, ntc, _CMP_LT_OQ), _mm256_cmp_pd(od, ntc, _CMP_LT_OQ))));
+
+    return ~_mm256_movemask_pd(sep) & 0xF;
+}
+
+__attribute__((target("avx2")))
+inline size_t first_crossing_avx2(const Query& q, const double* cx, const double* cy,
+                                  const double* dx, const double* dy, size_t count) {
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        int maybe = maybe_mask_avx2(q, cx + k, cy + k, dx + k, dy + k);
+        while (maybe) {
+            int lane = __builtin_ctz(maybe);
+            if (exact(q, cx[k + lane], cy[k + lane], dx[k + lane], dy[k + lane])) {
+                return k + lane;
+            }
+            maybe &= maybe - 1;
+        }
+    }
+    size_t tail = first_crossing_scalar(q, cx + k, cy + k, dx + k, dy + k, count - k);
+    return k + tail;
+}
+
+inline bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif
+
+// Номер первого отрезка блока, который пересекает ab (по правилу rule), или count, если таких нет.
+// AVX2 выбирается во время выполнения, если процессор его поддерживает.
+inline size_t first_crossing(const Point& a, const Point& b, const double* cx, const double* cy,
+                             const double* dx, const double* dy, size_t count,
+                             CrossingRule rule = CrossingRule::legacy) {
+    Query q{ a.x_, a.y_, b.x_, b.y_, rule };
+#ifdef CROSSES_SIMD_X86
+    if (has_avx2()) {
+        return first_crossing_avx2(q, cx, cy, dx, dy, count);
+    }
+#endif
+    return first_crossing_scalar(q, cx, cy, dx, dy, count);
+}
+
+// маска пересечений для блока до 64 отрезков: бит k - ab пересекает k-й отрезок
+inline uint64_t crossing_mask(const Point& a, const Point& b, const double* cx, const double* cy,
+                              const double* dx, const double* dy, size_t count,
+                              CrossingRule rule = CrossingRule::legacy) {
+    uint64_t mask = 0;
+    size_t k = 0;
+    while (k < count && k < 64) {
+        k += first_crossing(a, b, cx + k, cy + k, dx + k, dy + k, std::min<size_t>(count, 64) - k, rule);
+        if (k < count && k < 64) {
+            mask |= uint64_t(1) << k;
+            k++;
+        }
+    }
+    return mask;
+}
+
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <limits>
+#include "mesh.hpp"
+#include "predicates.hpp"
+#include "segment_index.hpp"
+
+
+// Триангуляция Делоне (Bowyer - Watson). Точки вставляются по одной: треугольники, в описанную
+// окружность которых попала точка, удаляются, а полость заполняется треугольниками с вершиной в ней.
+// За оболочкой лежат "призрачные" треугольники с бесконечно удалённой вершиной: охватывающий
+// треугольник не нужен, и оболочка получается точной. Все проверки - точными предикатами.
+// Сначала вставляются вершины выпуклой оболочки, потом остальные змейкой по ячейкам сетки; треугольник
+// с новой точкой ищется шагами от последнего построенного. Так и шагов, и удаляемых треугольников
+// в среднем O(1), а всё вместе - O(n log n) за счёт сортировок. (Если оболочка растёт вместе со
+// вставками, точка за длинной стороной из точек на одной прямой, как у решётки, удаляет все
+// призрачные треугольники этой стороны.)
+// Совпадающие точки берутся один раз (по меньшему номеру); если все точки на одной прямой, они
+// соединяются цепочкой.
+namespace delaunay_detail {
+
+const uint32_t kInfinite = std::numeric_limits<uint32_t>::max();
+
+class BowyerWatson {
+public:
+    explicit BowyerWatson(const PointSet& points) : p_(points), next_of_(points.size() + 1) {}
+
+    // a, b, c - не на одной прямой
+    void start(uint32_t a, uint32_t b, uint32_t c) {
+        if (orient(a, b, c) < 0) {
+            std::swap(b, c);
+        }
+        uint32_t t = add(a, b, c);
+        uint32_t gab = add(b, a, kInfinite);
+        uint32_t gbc = add(c, b, kInfinite);
+        uint32_t gca = add(a, c, kInfinite);
+        // сосед k - через ребро напротив вершины k
+        set_neighbours(t, gbc, gca, gab);
+        set_neighbours(gab, gca, gbc, t);
+        set_neighbours(gbc, gab, gca, t);
+        set_neighbours(gca, gbc, gab, t);
+        last_ = t;
+    }
+
+    void insert(uint32_t q) {
+        uint32_t t0 = locate(q);
+        if (++epoch_ == 0) {
+            std::fill(mark_.begin(), mark_.end(), 0);
+            epoch_ = 1;
+        }
+        cavity_.assign(1, t0);
+        mark_[t0] = epoch_;
+        boundary_.clear();
+        for (size_t k = 0; k < cavity_.size(); k++) {
+            uint32_t t = cavity_[k];
+            for (int e = 0; e < 3; e++) {
+                uint32_t s = n_[3 * t + e];
+                if (mark_[s] == epoch_) {
+                    continue;
+                }
+                if (conflict(s, q)) {
+                    mark_[s] = epoch_;
+                    cavity_.push_back(s);
+                }
+                else {
+                    boundary_.push_back({ v_[3 * t + (e + 1) % 3], v_[3 * t + (e + 2) % 3], s, 0 });
+                }
+            }
+        }
+        for (uint32_t t : cavity_) {
+            dead_[t] = 1;
+            free_.push_back(t);
+        }
+        // полость звёздна относительно q: по каждой вершине её границы выходит ровно одно ребро
+        for (Side& side : boundary_) {
+            uint32_t t = add(side.a, side.b, q);
+            side.made = t;
+            n_[3 * t + 2] = side.outer;
+            uint32_t s = side.outer;
+            for (int e = 0; e < 3; e++) {
+                uint32_t w = v_[3 * s + e];
+                if (w != side.a && w != side.b) {
+                    n_[3 * s + e] = t;
+                }
+            }
+            next_of_[slot(side.a)] = t;
+            if (side.a != kInfinite && side.b != kInfinite) {
+                last_ = t;
+            }
+        }
+        // (a, b, q) и (b, c, q) делят ребро bq
+        for (const Side& side : boundary_) {
+            uint32_t x = next_of_[slot(side.b)];
+            n_[3 * side.made] = x;
+            n_[3 * x + 1] = side.made;
+        }
+    }
+
+    // рёбра (i < j) всех настоящих треугольников, каждое один раз
+    template <class F>
+    void for_each_edge(F&& f) const {
+        for (uint32_t t = 0; t < v_.size() / 3; t++) {
+            if (dead_[t] || ghost(t)) {
+                continue;
+            }
+            for (int e = 0; e < 3; e++) {
+                uint32_t a = v_[3 * t + (e + 1) % 3];
+                uint32_t b = v_[3 * t + (e + 2) % 3];
+                if (a < b || ghost(n_[3 * t + e])) {
+                    f(std::min(a, b), std::max(a, b));
+                }
+            }
+        }
+    }
+
+private:
+    // ребро ab границы полости (полость слева), outer - треугольник за ним, made - новый треугольник abq
+    struct Side {
+        uint32_t a;
+        uint32_t b;
+        uint32_t outer;
+        uint32_t made;
+    };
+
+    int orient(uint32_t a, uint32_t b, uint32_t c) const {
+        return predicates::orient2d(p_.xs[a], p_.ys[a], p_.xs[b], p_.ys[b], p_.xs[c], p_.ys[c]);
+    }
+
+    size_t slot(uint32_t v) const {
+        return v == kInfinite ? next_of_.size() - 1 : v;
+    }
+
+    bool ghost(uint32_t t) const {
+        return v_[3 * t] == kInfinite || v_[3 * t + 1] == kInfinite || v_[3 * t + 2] == kInfinite;
+    }
+
+    // попадает ли q в описанную окружность t; у призрачного (x, y, inf) это открытая полуплоскость
+    // слева от x -> y и сам отрезок xy без концов
+    bool conflict(uint32_t t, uint32_t q) const {
+        const uint32_t* v = &v_[3 * t];
+        for (int k = 0; k < 3; k++) {
+            if (v[k] != kInfinite) {
+                continue;
+            }
+            uint32_t x = v[(k + 1) % 3], y = v[(k + 2) % 3];
+            int o = orient(x, y, q);
+            if (o != 0) {
+                return o > 0;
+            }
+            bool by_x = p_.xs[x] != p_.xs[y];
+            double lo = by_x ? std::min(p_.xs[x], p_.xs[y]) : std::min(p_.ys[x], p_.ys[y]);
+            double hi = by_x ? std::max(p_.xs[x], p_.xs[y]) : std::max(p_.ys[x], p_.ys[y]);
+            double at = by_x ? p_.xs[q] : p_.ys[q];
+            return lo < at && at < hi;
+        }
+        return predicates::incircle(p_.xs[v[0]], p_.ys[v[0]], p_.xs[v[1]], p_.ys[v[1]],
+                                    p_.xs[v[2]], p_.ys[v[2]], p_.xs[q], p_.ys[q]) > 0;
+    }
+
+    // треугольник в конфликте с q: шагаем по настоящим треугольникам через ребро, за которым лежит q;
+    // вышли за оболочку - призрачный треугольник за этим ребром и есть ответ
+    uint32_t locate(uint32_t q) const {
+        uint32_t t = last_;
+        for (;;) {
+            bool moved = false;
+            for (int e = 0; e < 3 && !moved; e++) {
+                uint32_t a = v_[3 * t + (e + 1) % 3];
+                uint32_t b = v_[3 * t + (e + 2) % 3];
+                if (orient(a, b, q) < 0) {
+                    t = n_[3 * t + e];
+                    moved = true;
+                }
+            }
+            if (!moved || ghost(t)) {
+                return t;
+            }
+        }
+    }
+
+    uint32_t add(uint32_t a, uint32_t b, uint32_t c) {
+        uint32_t t;
+        if (free_.empty()) {
+            t = uint32_t(v_.size() / 3);
+            v_.resize(v_.size() + 3);
+            n_.resize(n_.size() + 3);
+            dead_.push_back(0);
+            mark_.push_back(0);
+        }
+        else {
+            t = free_.back();
+            free_.pop_back();
+            dead_[t] = 0;
+        }
+        v_[3 * t] = a;
+        v_[3 * t + 1] = b;
+        v_[3 * t + 2] = c;
+        return t;
+    }
+
+    void set_neighbours(uint32_t t, uint32_t n0, uint32_t n1, uint32_t n2) {
+        n_[3 * t] = n0;
+        n_[3 * t + 1] = n1;
+        n_[3 * t + 2] = n2;
+    }
+
+    const PointSet& p_;
+    std::vector<uint32_t> v_;         // вершины треугольников, против часовой стрелки
+    std::vector<uint32_t> n_;         // соседи: n_[3t + k] - через ребро напротив вершины k
+    std::vector<char> dead_;
+    std::vector<uint32_t> mark_;
+    std::vector<uint32_t> free_;
+    std::vector<uint32_t> cavity_;
+    std::vector<Side> boundary_;
+    std::vector<uint32_t> next_of_;   // новый треугольник, чьё ребро границы полости начинается в вершине
+    uint32_t epoch_ = 0;
+    uint32_t last_ = 0;
+};
+
+}
+
+// рёбра триангуляции Делоне (i < j), каждое один раз, без определённого порядка
+inline EdgeList triangulate_delaunay(const PointSet& points) {
+    using namespace delaunay_detail;
+    EdgeList result;
+    const uint32_t n = uint32_t(points.size());
+
+    // без повторов: из совпадающих точек остаётся точка с меньшим номером
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (points.xs[a] != points.xs[b]) {
+            return points.xs[a] < points.xs[b];
+        }
+        return points.ys[a] != points.ys[b] ? points.ys[a] < points.ys[b] : a < b;
+    });
+    order.erase(std::unique(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return points.xs[a] == points.xs[b] && points.ys[a] == points.ys[b];
+    }), order.end());
+    if (order.size() < 2) {
+        return result;
+    }
+
+    // выпуклая оболочка без точек на сторонах (order уже отсортирован по x, затем y)
+    std::vector<uint32_t> hull(2 * order.size());
+    size_t h = 0;
+    auto turn = [&](uint32_t a, uint32_t b, uint32_t c) {
+        return predicates::orient2d(points.xs[a], points.ys[a], points.xs[b], points.ys[b], points.xs[c], points.ys[c]);
+    };
+    for (size_t k = 0; k < order.size(); k++) {
+        while (h >= 2 && turn(hull[h - 2], hull[h - 1], order[k]) <= 0) {
+            h--;
+        }
+        hull[h++] = order[k];
+    }
+    for (size_t k = order.size() - 1, lower = h + 1; k > 0; k--) {
+        while (h >= lower && turn(hull[h - 2], hull[h - 1], order[k - 1]) <= 0) {
+            h--;
+        }
+        hull[h++] = order[k - 1];
+    }
+    hull.resize(h - 1);
+    // все точки на одной прямой - цепочка в порядке вдоль неё
+    if (hull.size() < 3) {
+        result.reserve(order.size() - 1);
+        for (size_t k = 0; k + 1 < order.size(); k++) {
+            result.push_back(std::min(order[k], order[k + 1]), std::max(order[k], order[k + 1]));
+        }
+        return result;
+    }
+
+    // остальные - змейкой по ячейкам сетки, чтобы соседние вставки были рядом
+    std::vector<char> on_hull(n, 0);
+    for (uint32_t v : hull) {
+        on_hull[v] = 1;
+    }
+    UniformGrid grid(points, 1.0);
+    auto key = [&](uint32_t i) {
+        int col = grid.col(points.xs[i]), row = grid.row(points.ys[i]);
+        return uint64_t(row) * uint64_t(grid.cols) + uint64_t(row % 2 ? grid.cols - 1 - col : col);
+    };
+    std::vector<std::pair<uint64_t, uint32_t>> keyed;
+    keyed.reserve(order.size() - hull.size());
+    for (uint32_t i : order) {
+        if (!on_hull[i]) {
+            keyed.push_back({ key(i), i });
+        }
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    BowyerWatson mesh(points);
+    mesh.start(hull[0], hull[1], hull[2]);
+    for (size_t k = 3; k < hull.size(); k++) {
+        mesh.insert(hull[k]);
+    }
+    for (const auto& item : keyed) {
+        mesh.insert(item.second);
+    }
+    result.reserve(3 * size_t(n));
+    mesh.for_each_edge([&](uint32_t i, uint32_t j) { result.push_back(i, j); });
+    return result;
+}
@@ -0,0 +1,747 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <initializer_list>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "segment_index.hpp"
+#include "edge_sort.hpp"
+#include "predicates.hpp"
+#include "triangulate.hpp"
+
+
+// Жадная триангуляция, которая обновляется при добавлении и удалении точек.
+// Результат всегда тот же, что у triangulate_fast() по живым точкам (в порядке номеров).
+//
+// Обновление локальное: жадный алгоритм заново прогоняется только по точкам в круге радиуса 2r
+// вокруг изменения, рёбра точек из круга радиуса r заменяются новыми, остальные рёбра остаются.
+// Затем замена проверяется: жадный результат - это ровно те пары, которые не пересекает
+// ни одно более раннее (короче) принятое ребро, и проверять достаточно пары, чей статус мог измениться:
+//  - добавленные рёбра не должны пересекаться ни с одним ребром (более позднее пересечённое
+//    ребро снимается, и дальше проверяется вместе с убранными);
+//  - пары, пересекающие убранное ребро, и пары с новой точкой должны быть закрыты более ранним ребром.
+// Перебор пар ограничивает радиус веера: если все углы вокруг точки q закрыты треугольниками из
+// принятых рёбер длиной не больше R(q), то любая пара q-x длиннее R(q) пересекает сторону
+// одного из этих треугольников, то есть закрыта; у точки на оболочке внешний угол закрывать не нужно, поэтому
+// оболочка (соседи по ней) поддерживается вместе с рёбрами. Пары двух незакрытых точек перебираются отдельно:
+// после полной триангуляции таких точек почти нет (совпадающие точки, все точки на одной прямой), а если
+// их много, дешевле пересчитать всё. Если проверка не прошла, r удваивается;
+// когда круг накрывает все точки, триангуляция пересчитывается целиком.
+// Оценка радиусом веера точна для CrossingRule::robust (по умолчанию); для legacy - те же
+// оговорки, что и у triangulate_fast() (точки в общем положении).
+class DynamicTriangulation {
+public:
+    // что произошло при последнем обновлении
+    struct UpdateStats {
+        size_t region = 0;     // точек в последнем пересчитанном круге
+        size_t rounds = 0;     // сколько кругов пробовали
+        size_t added = 0;      // рёбер добавлено
+        size_t removed = 0;    // рёбер убрано
+        bool rebuilt = false;  // пришлось пересчитать всё
+    };
+
+    explicit DynamicTriangulation(CrossingRule rule = CrossingRule::robust)
+        : rule_(rule) {}
+
+    explicit DynamicTriangulation(const PointSet& points, CrossingRule rule = CrossingRule::robust)
+        : rule_(rule), pts_(points), alive_(points.size(), 1), alive_count_(points.size()) {
+        rebuild();
+    }
+
+    // добавить точку; возвращает её номер (номера не переиспользуются)
+    uint32_t insert(const Point& p) {
+        uint32_t id = uint32_t(pts_.size());
+        pts_.push_back(p.x_, p.y_);
+        alive_.push_back(1);
+        adj_.emplace_back();
+        radius_.push_back(-1);
+        hull_prev_.push_back(kNone);
+        hull_next_.push_back(kNone);
+        alive_count_++;
+        if (p.x_ < grid_.min_x || p.x_ > grid_.max_x || p.y_ < grid_.min_y || p.y_ > grid_.max_y) {
+            outside_++;
+        }
+        if (needs_rebuild()) {
+            rebuild();
+            return id;
+        }
+        buckets_[cell_of(id)].push_back(id);
+        if (!inside_hull(id)) {
+            for (uint32_t q : build_hull()) {
+                refresh_radius(q);
+            }
+        }
+        repair(p.x_, p.y_, id, {});
+        return id;
+    }
+
+    // удалить точку id вместе с её рёбрами
+    void remove(uint32_t id) {
+        if (id >= pts_.size() || !alive_[id]) {
+            return;
+        }
+        alive_[id] = 0;
+        alive_count_--;
+        forget_radius(id);
+        std::vector<uint32_t>& bucket = buckets_[cell_of(id)];
+        bucket.erase(std::find(bucket.begin(), bucket.end(), id));
+
+        std::vector<std::pair<uint32_t, uint32_t>> dropped;
+        std::vector<uint32_t> touched;
+        for (uint32_t r : std::vector<uint32_t>(adj_[id])) {
+            dropped.push_back(ordered(id, r));
+            drop_edge(id, r);
+            touched.push_back(r);
+        }
+        if (hull_next_[id] != kNone) {
+            std::vector<uint32_t> chain = remove_from_hull(id);
+            touched.insert(touched.end(), chain.begin(), chain.end());
+        }
+        refresh_around(touched);
+        if (needs_rebuild()) {
+            rebuild();
+            return;
+        }
+        repair(pts_.xs[id], pts_.ys[id], kNone, dropped);
+    }
+
+    bool alive(uint32_t id) const {
+        return id < alive_.size() && alive_[id];
+    }
+
+    // число живых точек
+    size_t size() const {
+        return alive_count_;
+    }
+
+    // все точки, включая удалённые (номера - индексы здесь)
+    const PointSet& points() const {
+        return pts_;
+    }
+
+    // номера живых точек по возрастанию
+    std::vector<uint32_t> ids() const {
+        std::vector<uint32_t> result;
+        result.reserve(alive_count_);
+        for (uint32_t i = 0; i < alive_.size(); i++) {
+            if (alive_[i]) {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+
+    // принятые рёбра в порядке принятия (длина, затем номера)
+    EdgeList edges() const {
+        std::vector<CandidateEdge> list;
+        list.reserve(seg_of_.size());
+        for (auto& item : seg_of_) {
+            uint32_t i = uint32_t(item.first >> 32), j = uint32_t(item.first);
+            list.push_back({ pts_.length(i, j), i, j });
+        }
+        std::sort(list.begin(), list.end(), candidate_less);
+        EdgeList result;
+        result.reserve(list.size());
+        for (const CandidateEdge& e : list) {
+            result.push_back(e.i, e.j);
+        }
+        return result;
+    }
+
+    const UpdateStats& last_update() const {
+        return stats_;
+    }
+
+private:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    using Pair = std::pair<uint32_t, uint32_t>;
+
+    static Pair ordered(uint32_t i, uint32_t j) {
+        return i < j ? Pair(i, j) : Pair(j, i);
+    }
+
+    static uint64_t key(const Pair& e) {
+        return (uint64_t(e.first) << 32) | e.second;
+    }
+
+    bool has_edge(uint32_t i, uint32_t j) const {
+        return seg_of_.count(key(ordered(i, j))) != 0;
+    }
+
+    // e раньше f в порядке жадного алгоритма
+    bool earlier(const Pair& e, const Pair& f) const {
+        return candidate_less({ pts_.length(e.first, e.second), e.first, e.second },
+                              { pts_.length(f.first, f.second), f.first, f.second });
+    }
+
+    bool conflict(const Pair& e, const Pair& f) const {
+        return segments_cross(pts_.xs[e.first], pts_.ys[e.first], pts_.xs[e.second], pts_.ys[e.second],
+                              pts_.xs[f.first], pts_.ys[f.first], pts_.xs[f.second], pts_.ys[f.second], rule_);
+    }
+
+    void add_edge(uint32_t i, uint32_t j) {
+        Pair e = ordered(i, j);
+        uint32_t id = index_.insert(pts_[e.first], pts_[e.second]);
+        seg_of_[key(e)] = id;
+        if (pair_of_.size() <= id) {
+            pair_of_.resize(id + 1);
+        }
+        pair_of_[id] = e;
+        adj_[i].push_back(j);
+        adj_[j].push_back(i);
+    }
+
+    void drop_edge(uint32_t i, uint32_t j) {
+        auto it = seg_of_.find(key(ordered(i, j)));
+        index_.remove(it->second);
+        seg_of_.erase(it);
+        adj_[i].erase(std::find(adj_[i].begin(), adj_[i].end(), j));
+        adj_[j].erase(std::find(adj_[j].begin(), adj_[j].end(), i));
+    }
+
+    // R(q): см. greedy_detail::fan_radius
+    double fan_radius(uint32_t q) {
+        return greedy_detail::fan_radius(pts_, q, adj_[q], [&](uint32_t a, uint32_t b) { return has_edge(a, b); },
+                                         around_, hull_prev_[q], hull_next_[q]);
+    }
+
+    // точка id строго внутри оболочки остальных живых точек (обход оболочки, O(h))
+    bool inside_hull(uint32_t id) const {
+        if (hull_start_ == kNone) {
+            return false;
+        }
+        uint32_t u = hull_start_;
+        do {
+            uint32_t w = hull_next_[u];
+            if (greedy_detail::orient(pts_, u, w, id) <= 0) {
+                return false;
+            }
+            u = w;
+        } while (u != hull_start_);
+        return true;
+    }
+
+    // оболочка живых точек заново (greedy_detail::hull_links); возвращает точки, у которых сменились соседи по ней
+    std::vector<uint32_t> build_hull() {
+        std::vector<uint32_t> alive_ids = ids();
+        PointSet sub;
+        sub.reserve(alive_ids.size());
+        for (uint32_t id : alive_ids) {
+            sub.push_back(pts_.xs[id], pts_.ys[id]);
+        }
+        std::vector<uint32_t> prev(sub.size(), kNone), next(sub.size(), kNone);
+        if (sub.size() >= 2) {
+            UniformGrid grid(sub, 2.0);
+            greedy_detail::PointBuckets buckets(grid, sub);
+            greedy_detail::hull_links(sub, grid, buckets, prev, next);
+        }
+        return set_hull(alive_ids, prev, next);
+    }
+
+    // соседи по оболочке из номеров в alive_ids
+    std::vector<uint32_t> set_hull(const std::vector<uint32_t>& alive_ids, const std::vector<uint32_t>& prev,
+                                   const std::vector<uint32_t>& next) {
+        std::vector<uint32_t> changed;
+        hull_start_ = kNone;
+        for (size_t k = 0; k < alive_ids.size(); k++) {
+            uint32_t id = alive_ids[k];
+            uint32_t p = prev[k] == kNone ? kNone : alive_ids[prev[k]];
+            uint32_t n = next[k] == kNone ? kNone : alive_ids[next[k]];
+            if (hull_prev_[id] != p || hull_next_[id] != n) {
+                hull_prev_[id] = p;
+                hull_next_[id] = n;
+                changed.push_back(id);
+            }
+            if (n != kNone) {
+                hull_start_ = id;
+            }
+        }
+        return changed;
+    }
+
+    // Убрать с оболочки уже удалённую точку p. Новый участок оболочки между её соседями a и b - оболочка
+    // точек треугольника a, p, b (остальные лежат по другую сторону ab), поэтому просматривается только он.
+    // Возвращает точки участка от a до b.
+    std::vector<uint32_t> remove_from_hull(uint32_t p) {
+        uint32_t a = hull_prev_[p], b = hull_next_[p];
+        hull_prev_[p] = hull_next_[p] = kNone;
+        if (a == b || hull_prev_[a] == b) {
+            // оставалось не больше трёх точек оболочки - считаем заново
+            return build_hull();
+        }
+        if (hull_start_ == p) {
+            hull_start_ = a;
+        }
+        std::vector<uint32_t> inside;
+        if (greedy_detail::orient(pts_, a, p, b) > 0) {
+            for_points_in_box(std::min({ pts_.xs[a], pts_.xs[p], pts_.xs[b] }), std::min({ pts_.ys[a], pts_.ys[p], pts_.ys[b] }),
+                              std::max({ pts_.xs[a], pts_.xs[p], pts_.xs[b] }), std::max({ pts_.ys[a], pts_.ys[p], pts_.ys[b] }),
+                              [&](uint32_t q) {
+                if (q != a && q != b && greedy_detail::orient(pts_, a, p, q) >= 0 &&
+                    greedy_detail::orient(pts_, p, b, q) >= 0 && greedy_detail::orient(pts_, b, a, q) >= 0) {
+                    inside.push_back(q);
+                }
+            });
+        }
+        // участок - выпуклая цепочка от a до b по ту же сторону ab, что и p: точки по проекции на ab,
+        // поворот только влево (как в hull_links); точки на прямой ab в неё не входят
+        double dx = pts_.xs[b] - pts_.xs[a], dy = pts_.ys[b] - pts_.ys[a];
+        auto along = [&](uint32_t q) {
+            return (pts_.xs[q] - pts_.xs[a]) * dx + (pts_.ys[q] - pts_.ys[a]) * dy;
+        };
+        std::vector<uint32_t> order;
+        for (uint32_t q : inside) {
+            if (greedy_detail::orient(pts_, a, b, q) < 0) {
+                order.push_back(q);
+            }
+        }
+        // при равной проекции первой идёт дальняя от ab, а на одном луче из a - ближняя к a
+        std::sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) {
+            if (along(l) != along(r)) {
+                return along(l) < along(r);
+            }
+            int o = greedy_detail::orient(pts_, a, l, r);
+            if (o != 0) {
+                return o > 0;
+            }
+            return std::hypot(pts_.xs[l] - pts_.xs[a], pts_.ys[l] - pts_.ys[a]) <
+                   std::hypot(pts_.xs[r] - pts_.xs[a], pts_.ys[r] - pts_.ys[a]);
+        });
+        order.push_back(b);
+        std::vector<uint32_t> chain = { a };
+        for (uint32_t q : order) {
+            while (chain.size() >= 2 && greedy_detail::orient(pts_, chain[chain.size() - 2], chain.back(), q) <= 0) {
+                chain.pop_back();
+            }
+            chain.push_back(q);
+        }
+        // точки на сторонах цепочки тоже на оболочке, по порядку
+        std::vector<uint32_t> result;
+        std::vector<std::pair<double, uint32_t>> on_side;
+        for (size_t k = 0; k + 1 < chain.size(); k++) {
+            uint32_t u = chain[k], w = chain[k + 1];
+            on_side.clear();
+            for (uint32_t q : inside) {
+                if (q == u || q == w || greedy_detail::orient(pts_, u, w, q) != 0) {
+                    continue;
+                }
+                double t = (pts_.xs[q] - pts_.xs[u]) * (pts_.xs[w] - pts_.xs[u]) + (pts_.ys[q] - pts_.ys[u]) * (pts_.ys[w] - pts_.ys[u]);
+                double s = (pts_.xs[q] - pts_.xs[w]) * (pts_.xs[u] - pts_.xs[w]) + (pts_.ys[q] - pts_.ys[w]) * (pts_.ys[u] - pts_.ys[w]);
+                if (t > 0 && s > 0) {
+                    on_side.push_back({ t, q });
+                }
+            }
+            std::sort(on_side.begin(), on_side.end());
+            result.push_back(u);
+            for (auto& item : on_side) {
+                result.push_back(item.second);
+            }
+        }
+        result.push_back(b);
+        for (size_t k = 0; k + 1 < result.size(); k++) {
+            hull_next_[result[k]] = result[k + 1];
+            hull_prev_[result[k + 1]] = result[k];
+        }
+        return result;
+    }
+
+    void forget_radius(uint32_t q) {
+        double r = radius_[q];
+        if (r < 0) {
+            return;
+        }
+        if (std::isinf(r)) {
+            unclosed_.erase(q);
+        }
+        else {
+            closed_radii_.erase(closed_radii_.find(r));
+        }
+        radius_[q] = -1;
+    }
+
+    void refresh_radius(uint32_t q) {
+        forget_radius(q);
+        if (!alive_[q]) {
+            return;
+        }
+        double r = fan_radius(q);
+        radius_[q] = r;
+        if (std::isinf(r)) {
+            unclosed_.insert(q);
+        }
+        else {
+            closed_radii_.insert(r);
+        }
+    }
+
+    // пересчитать R у точек и их соседей (у соседа могла поменяться сторона треугольника вокруг него)
+    void refresh_around(const std::vector<uint32_t>& points) {
+        stamp_++;
+        auto touch = [&](uint32_t q) {
+            if (seen_[q] != stamp_) {
+                seen_[q] = stamp_;
+                refresh_radius(q);
+            }
+        };
+        seen_.resize(pts_.size(), 0);
+        for (uint32_t q : points) {
+            touch(q);
+            for (uint32_t r : adj_[q]) {
+                touch(r);
+            }
+        }
+    }
+
+    int cell_of(uint32_t id) const {
+        return grid_.index(grid_.col(pts_.xs[id]), grid_.row(pts_.ys[id]));
+    }
+
+    template <class F>
+    void for_points_in_box(double x0, double y0, double x1, double y1, F&& f) const {
+        for (int r = grid_.row(y0); r <= grid_.row(y1); r++) {
+            for (int c = grid_.col(x0); c <= grid_.col(x1); c++) {
+                for (uint32_t q : buckets_[grid_.index(c, r)]) {
+                    if (pts_.xs[q] >= x0 && pts_.xs[q] <= x1 && pts_.ys[q] >= y0 && pts_.ys[q] <= y1) {
+                        f(q);
+                    }
+                }
+            }
+        }
+    }
+
+    // расстояние до k-й ближайшей живой точки (приблизительно: по кольцам ячеек)
+    double kth_distance(double x, double y, size_t k) const {
+        std::vector<double> dist;
+        for (int ring = 0; ; ring++) {
+            double reach = ring * grid_.cell;
+            dist.clear();
+            for_points_in_box(x - reach, y - reach, x + reach, y + reach, [&](uint32_t q) {
+                dist.push_back(std::hypot(pts_.xs[q] - x, pts_.ys[q] - y));
+            });
+            if (dist.size() > k || reach > grid_.diagonal()) {
+                break;
+            }
+        }
+        if (dist.size() <= k) {
+            return grid_.diagonal();
+        }
+        std::nth_element(dist.begin(), dist.begin() + k, dist.end());
+        return std::max(dist[k], grid_.cell);
+    }
+
+    // незакрытых точек так много, что перебор их пар дороже пересчёта, - тоже пересчёт
+    bool needs_rebuild() const {
+        return alive_count_ < 16 || alive_count_ > 2 * grid_count_ + 64 || 4 * alive_count_ + 64 < grid_count_ ||
+               outside_ > alive_count_ / 16 + 64 || index_.size() > 4 * seg_of_.size() + 4096 ||
+               unclosed_.size() * unclosed_.size() > alive_count_ + 4096;
+    }
+
+    // пересчёт с нуля по всем живым точкам
+    void rebuild() {
+        std::vector<uint32_t> alive_ids = ids();
+        PointSet sub;
+        sub.reserve(alive_ids.size());
+        for (uint32_t id : alive_ids) {
+            sub.push_back(pts_.xs[id], pts_.ys[id]);
+        }
+        grid_ = UniformGrid(sub, 2.0);
+        grid_count_ = alive_ids.size();
+        outside_ = 0;
+        buckets_.assign(grid_.size(), {});
+        for (uint32_t id : alive_ids) {
+            buckets_[cell_of(id)].push_back(id);
+        }
+        index_.reset(grid_, rule_);
+        seg_of_.clear();
+        pair_of_.clear();
+        adj_.assign(pts_.size(), {});
+        triangulate_fast_stream(sub, [&](uint32_t i, uint32_t j) { add_edge(alive_ids[i], alive_ids[j]); }, rule_,
+                                workspace_);
+        // оболочку уже нашёл triangulate_fast_stream (при двух точках и больше)
+        hull_prev_.assign(pts_.size(), kNone);
+        hull_next_.assign(pts_.size(), kNone);
+        if (sub.size() >= 2) {
+            set_hull(alive_ids, workspace_.hull_prev, workspace_.hull_next);
+        }
+        else {
+            hull_start_ = kNone;
+        }
+
+        radius_.assign(pts_.size(), -1);
+        closed_radii_.clear();
+        unclosed_.clear();
+        for (uint32_t id : alive_ids) {
+            refresh_radius(id);
+        }
+        stats_.rebuilt = true;
+        stats_.region = alive_ids.size();
+    }
+
+    // локальное обновление вокруг (x, y); fresh - новая точка, dropped - уже убранные рёбра удалённой точки
+    void repair(double x, double y, uint32_t fresh, const std::vector<Pair>& dropped) {
+        STATS_STAGE("repair");
+        stats_ = UpdateStats();
+        stats_.removed = dropped.size();
+        double rho = 2 * kth_distance(x, y, 8);
+        std::vector<char> inner(pts_.size(), 0), support(pts_.size(), 0);
+
+        for (;;) {
+            stats_.rounds++;
+            std::vector<uint32_t> near;
+            for_points_in_box(x - 2 * rho, y - 2 * rho, x + 2 * rho, y + 2 * rho, [&](uint32_t q) {
+                if (std::hypot(pts_.xs[q] - x, pts_.ys[q] - y) <= 2 * rho) {
+                    near.push_back(q);
+                }
+            });
+            if (near.size() >= alive_count_) {
+                size_t removed = stats_.removed;
+                rebuild();
+                stats_.rounds++;
+                stats_.removed = removed;
+                return;
+            }
+            std::sort(near.begin(), near.end());
+            stats_.region = near.size();
+
+            // жадная триангуляция внутри большого круга; берём рёбра точек малого круга
+            PointSet sub;
+            sub.reserve(near.size());
+            for (uint32_t q : near) {
+                sub.push_back(pts_.xs[q], pts_.ys[q]);
+                support[q] = 1;
+                inner[q] = std::hypot(pts_.xs[q] - x, pts_.ys[q] - y) <= rho;
+            }
+            std::vector<Pair> old_edges;
+            for (uint32_t q : near) {
+                for (uint32_t r : adj_[q]) {
+                    // рёбра к точкам за пределами большого круга здесь не пересчитывались - остаются
+                    if ((inner[q] || inner[r]) && support[r] && (q < r || !inner[r] || !inner[q])) {
+                        old_edges.push_back(ordered(q, r));
+                    }
+                }
+            }
+            std::sort(old_edges.begin(), old_edges.end());
+            old_edges.erase(std::unique(old_edges.begin(), old_edges.end()), old_edges.end());
+            // оставшиеся рёбра, которые раньше пары и пересекают её, закрывают её и в круге: иначе точки круга
+            // соединялись бы в обход длинных рёбер к точкам снаружи (на выпуклых наборах - всегда)
+            auto kept_blocks = [&](uint32_t i, uint32_t j) {
+                Pair e = ordered(near[i], near[j]);
+                return index_.visit(pts_[e.first], pts_[e.second], [&](uint32_t id) {
+                    const Pair& f = pair_of_[id];
+                    return earlier(f, e) && conflict(e, f) && !std::binary_search(old_edges.begin(), old_edges.end(), f);
+                });
+            };
+            std::vector<Pair> fresh_edges;
+            triangulate_fast_stream(sub, [&](uint32_t i, uint32_t j) {
+                if (inner[near[i]] || inner[near[j]]) {
+                    fresh_edges.push_back(ordered(near[i], near[j]));
+                }
+            }, rule_, workspace_, kept_blocks);
+            std::sort(fresh_edges.begin(), fresh_edges.end());
+            std::vector<Pair> added, removed;
+            std::set_difference(fresh_edges.begin(), fresh_edges.end(), old_edges.begin(), old_edges.end(),
+                                std::back_inserter(added));
+            std::set_difference(old_edges.begin(), old_edges.end(), fresh_edges.begin(), fresh_edges.end(),
+                                std::back_inserter(removed));
+            for (uint32_t q : near) {
+                support[q] = inner[q] = 0;
+            }
+
+            for (const Pair& e : removed) {
+                drop_edge(e.first, e.second);
+            }
+            for (const Pair& e : added) {
+                add_edge(e.first, e.second);
+            }
+            std::vector<Pair> cascade;
+            bool ok = check_added(added, cascade);
+            std::vector<uint32_t> touched;
+            for (const std::vector<Pair>* list : std::initializer_list<const std::vector<Pair>*>{ &added, &removed, &cascade, &dropped }) {
+                for (const Pair& e : *list) {
+                    touched.push_back(e.first);
+                    touched.push_back(e.second);
+                }
+            }
+            if (fresh != kNone) {
+                touched.push_back(fresh);
+            }
+            refresh_around(touched);
+
+            if (ok) {
+                std::vector<Pair> gone(dropped);
+                gone.insert(gone.end(), removed.begin(), removed.end());
+                gone.insert(gone.end(), cascade.begin(), cascade.end());
+                ok = check_blocked(gone, fresh);
+            }
+            if (ok) {
+                stats_.added = added.size();
+                stats_.removed += removed.size() + cascade.size();
+                return;
+            }
+
+            // откат и круг побольше
+            for (const Pair& e : added) {
+                drop_edge(e.first, e.second);
+            }
+            for (const Pair& e : removed) {
+                add_edge(e.first, e.second);
+            }
+            for (const Pair& e : cascade) {
+                add_edge(e.first, e.second);
+            }
+            refresh_around(touched);
+            rho *= 2;
+        }
+    }
+
+    // добавленное ребро не должно пересекаться ни с чем; более позднее пересечённое ребро снимается
+    bool check_added(const std::vector<Pair>& added, std::vector<Pair>& cascade) {
+        for (const Pair& e : added) {
+            for (uint32_t id : index_.crossing(Edge(pts_[e.first], pts_[e.second]))) {
+                Pair f = pair_of_[id];
+                if (f == e) {
+                    continue;
+                }
+                if (earlier(f, e) || std::binary_search(added.begin(), added.end(), f)) {
+                    return false;
+                }
+                drop_edge(f.first, f.second);
+                cascade.push_back(f);
+            }
+        }
+        return true;
+    }
+
+    // пара не принята и её не закрывает более раннее принятое ребро - значит, результат не жадный
+    bool unblocked(const Pair& e) {
+        if (has_edge(e.first, e.second)) {
+            return false;
+        }
+        for (uint32_t id : index_.crossing(Edge(pts_[e.first], pts_[e.second]))) {
+            if (earlier(pair_of_[id], e)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // пары, пересекающие убранные рёбра, и пары с новой точкой должны быть закрыты
+    bool check_blocked(const std::vector<Pair>& gone, uint32_t fresh) {
+        const double slack = 1 + 1e-9;
+        double reach = closed_radii_.empty() ? 0 : *closed_radii_.rbegin() * slack;
+        std::vector<uint32_t> near, far;
+        auto blocked = [&](const Pair& e, const Pair& f) {
+            return pts_.length(e.first, e.second) > std::min(radius_[e.first], radius_[e.second]) * slack ||
+                   !(e == f || conflict(e, f)) || !unblocked(e);
+        };
+        for (const Pair& f : gone) {
+            double ax = pts_.xs[f.first], ay = pts_.ys[f.first];
+            double bx = pts_.xs[f.second], by = pts_.ys[f.second];
+            double x0 = std::min(ax, bx) - reach, y0 = std::min(ay, by) - reach;
+            double x1 = std::max(ax, bx) + reach, y1 = std::max(ay, by) + reach;
+            near.clear();
+            for_points_in_box(x0, y0, x1, y1, [&](uint32_t q) {
+                if (!std::isinf(radius_[q]) && point_segment_distance(q, ax, ay, bx, by) <= radius_[q] * slack) {
+                    near.push_back(q);
+                }
+            });
+            // незакрытые точки рядом с f - вместе с закрытыми; пара, пересекающая f, с концом дальше reach
+            // длиннее любого конечного R, так что второй её конец тоже незакрытый
+            far.clear();
+            for (uint32_t q : unclosed_) {
+                bool inside = pts_.xs[q] >= x0 && pts_.xs[q] <= x1 && pts_.ys[q] >= y0 && pts_.ys[q] <= y1;
+                (inside ? near : far).push_back(q);
+            }
+            for (size_t a = 0; a < near.size(); a++) {
+                for (size_t b = a + 1; b < near.size(); b++) {
+                    if (!blocked(ordered(near[a], near[b]), f)) {
+                        return false;
+                    }
+                }
+            }
+            for (size_t a = 0; a < far.size(); a++) {
+                for (uint32_t q : unclosed_) {
+                    if (q == far[a] || (q < far[a] && std::binary_search(far.begin(), far.end(), q))) {
+                        continue;
+                    }
+                    if (!blocked(ordered(far[a], q), f)) {
+                        return false;
+                    }
+                }
+            }
+            if (alive_[f.first] && alive_[f.second] && unblocked(f)) {
+                return false;
+            }
+        }
+
+        if (fresh != kNone) {
+            double own = radius_[fresh];
+            double r = std::isinf(own) ? reach : std::min(own * slack, reach);
+            double px = pts_.xs[fresh], py = pts_.ys[fresh];
+            near.clear();
+            for_points_in_box(px - r, py - r, px + r, py + r, [&](uint32_t q) {
+                if (!std::isinf(radius_[q])) {
+                    near.push_back(q);
+                }
+            });
+            // пара длиннее R(fresh) закрыта: дальние незакрытые точки нужны, только если fresh сама незакрыта
+            for (uint32_t q : unclosed_) {
+                if (std::isinf(own) || std::hypot(pts_.xs[q] - px, pts_.ys[q] - py) <= r) {
+                    near.push_back(q);
+                }
+            }
+            for (uint32_t q : near) {
+                if (q == fresh) {
+                    continue;
+                }
+                Pair e = ordered(fresh, q);
+                if (pts_.length(fresh, q) <= std::min(own, radius_[q]) * slack && unblocked(e)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    double point_segment_distance(uint32_t q, double ax, double ay, double bx, double by) const {
+        double px = pts_.xs[q] - ax, py = pts_.ys[q] - ay;
+        double dx = bx - ax, dy = by - ay;
+        double len2 = dx * dx + dy * dy;
+        double t = len2 > 0 ? std::min(1.0, std::max(0.0, (px * dx + py * dy) / len2)) : 0;
+        return std::hypot(px - t * dx, py - t * dy);
+    }
+
+    CrossingRule rule_;
+    PointSet pts_;
+    std::vector<char> alive_;
+    size_t alive_count_ = 0;
+
+    UniformGrid grid_;
+    std::vector<std::vector<uint32_t>> buckets_;
+    size_t grid_count_ = 0;
+    size_t outside_ = 0;
+
+    std::vector<std::vector<uint32_t>> adj_;
+    SegmentIndex index_;
+    std::unordered_map<uint64_t, uint32_t> seg_of_;
+    std::vector<Pair> pair_of_;
+
+    std::vector<double> radius_;
+    std::multiset<double> closed_radii_;
+    std::set<uint32_t> unclosed_;
+    std::vector<uint32_t> hull_prev_;    // соседи по оболочке живых точек (kNone - не на оболочке)
+    std::vector<uint32_t> hull_next_;
+    uint32_t hull_start_ = kNone;        // какая-нибудь точка оболочки
+
+    std::vector<std::pair<double, uint32_t>> around_;
+    std::vector<uint32_t> seen_;
+    TriangulationWorkspace workspace_;   // буферы локальных пересчётов, общие для всех обновлений
+    uint32_t stamp_ = 0;
+    UpdateStats stats_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstdint>
+#include "instrumentation.hpp"
+
+
+// Параллельная сортировка: куски сортируются в своих потоках, затем попарно сливаются.
+// less должен задавать строгий полный порядок (без равных элементов) - тогда результат
+// не зависит от числа потоков и совпадает с обычной сортировкой.
+template <class T, class Less>
+void parallel_sort(std::vector<T>& items, Less less, unsigned threads = 0) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t n = items.size();
+    // на маленьких массивах потоки дороже самой сортировки
+    if (threads == 1 || n < (size_t(1) << 15)) {
+        std::sort(items.begin(), items.end(), less);
+        return;
+    }
+    size_t parts = std::min<size_t>(threads, n / (size_t(1) << 13));
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t k = 0; k <= parts; k++) {
+        bounds[k] = n * k / parts;
+    }
+
+    std::vector<std::thread> pool;
+    for (size_t k = 0; k < parts; k++) {
+        pool.emplace_back([&, k] {
+            std::sort(items.begin() + bounds[k], items.begin() + bounds[k + 1], less);
+        });
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    std::vector<T> buffer(n);
+    while (bounds.size() > 2) {
+        std::vector<size_t> merged;
+        pool.clear();
+        for (size_t k = 0; k + 1 < bounds.size(); k += 2) {
+            merged.push_back(bounds[k]);
+            if (k + 2 >= bounds.size()) {
+                // непарный последний кусок просто переносим
+                pool.emplace_back([&, k] {
+                    std::move(items.begin() + bounds[k], items.begin() + bounds[k + 1], buffer.begin() + bounds[k]);
+                });
+                continue;
+            }
+            pool.emplace_back([&, k] {
+                std::merge(items.begin() + bounds[k], items.begin() + bounds[k + 1],
+                           items.begin() + bounds[k + 1], items.begin() + bounds[k + 2],
+                           buffer.begin() + bounds[k], less);
+            });
+        }
+        merged.push_back(n);
+        for (auto& t : pool) {
+            t.join();
+        }
+        items.swap(buffer);
+        bounds.swap(merged);
+    }
+}
+
+
+// кандидат в триангуляцию: номера концов (i < j) и заранее посчитанная длина
+struct CandidateEdge {
+    double len;
+    uint32_t i;
+    uint32_t j;
+};
+
+// порядок (длина, i, j) совпадает с устойчивой сортировкой по длине списка пар, перечисленных по i, затем j
+inline bool candidate_less(const CandidateEdge& l, const CandidateEdge& r) {
+    if (l.len != r.len) {
+        return l.len < r.len;
+    }
+    return l.i < r.i || (l.i == r.i && l.j < r.j);
+}
+
+inline void sort_candidates(std::vector<CandidateEdge>& candidates, unsigned threads = 0) {
+    STATS_STAGE("sort");
+    parallel_sort(candidates, candidate_less, threads);
+}
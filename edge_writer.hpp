@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <ostream>
+#include <fstream>
+#include <charconv>
+#include <stdexcept>
+#include <cstdint>
+#include "mesh.hpp"
+
+
+// Потоковая запись принятых рёбер: по строке на ребро, как только ребро принято.
+// Строка - "i j" (номера точек) или, при coordinates, "x1 y1 x2 y2".
+// Числа пишутся std::to_chars в свой буфер, в поток он сбрасывается, когда заполнится.
+// Объект можно передавать прямо как sink в triangulate_fast_stream().
+class EdgeWriter {
+public:
+    EdgeWriter(std::ostream& out, const PointSet& points, bool coordinates = false,
+               size_t buffer = size_t(1) << 16)
+        : out_(&out), points_(&points), coordinates_(coordinates) {
+        buffer_.resize(std::max<size_t>(buffer, 256));
+    }
+
+    // запись в файл path (ошибка открытия - std::runtime_error)
+    EdgeWriter(const std::string& path, const PointSet& points, bool coordinates = false)
+        : file_(new std::ofstream(path, std::ios::binary | std::ios::trunc)),
+          out_(file_.get()), points_(&points), coordinates_(coordinates) {
+        if (!file_->is_open()) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        buffer_.resize(size_t(1) << 16);
+    }
+
+    ~EdgeWriter() {
+        flush();
+    }
+
+    EdgeWriter(const EdgeWriter&) = delete;
+    EdgeWriter& operator=(const EdgeWriter&) = delete;
+
+    void operator()(uint32_t i, uint32_t j) {
+        // на строку уходит не больше 4 * 25 символов
+        if (buffer_.size() - used_ < 128) {
+            flush();
+        }
+        if (coordinates_) {
+            put(points_->xs[i], ' ');
+            put(points_->ys[i], ' ');
+            put(points_->xs[j], ' ');
+            put(points_->ys[j], '\n');
+        }
+        else {
+            put(i, ' ');
+            put(j, '\n');
+        }
+        count_++;
+    }
+
+    size_t count() const {
+        return count_;
+    }
+
+    void flush() {
+        out_->write(buffer_.data(), std::streamsize(used_));
+        out_->flush();
+        used_ = 0;
+    }
+
+private:
+    template <class T>
+    void put(T value, char separator) {
+        char* end = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value).ptr;
+        *end++ = separator;
+        used_ = size_t(end - buffer_.data());
+    }
+
+    std::unique_ptr<std::ofstream> file_;
+    std::ostream* out_;
+    const PointSet* points_;
+    bool coordinates_;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    size_t count_ = 0;
+};
@@ -0,0 +1,219 @@
+// Сравнение движков триангуляции по качеству и скорости на синтетических наборах точек.
+// Запуск: engine_compare [ключи], см. usage(). Результат - CSV (по строке на движок и n),
+// в stdout или в файл --out; ход работы печатается в stderr.
+// length_ratio - сумма длин рёбер относительно жадной триангуляции того же набора (1 - так же коротко),
+// speedup - во сколько раз движок быстрее жадного. Жадный всегда запускается первым; если его нет в --engine, отношения пустые.
+// Жадный по умолчанию считает точными предикатами: старая проверка пересечений на части наборов
+// (совпадающие точки, точки на одной прямой) даёт лишние или пропущенные рёбра, и сравнивать было бы не с чем.
+// same_as_mesh (для жадного, n <= --check) - 1, если его рёбра совпадают с перебором всех пар (triangulate_mesh)
+// с тем же правилом: так видно, на каких наборах старая проверка (--legacy) расходится с эталоном.
+// Движок, который на каком-то n занял больше --budget секунд, для больших n этого распределения пропускается.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "triangulator.hpp"
+#include "point_generators.hpp"
+
+
+struct CompareOptions {
+    std::vector<Distribution> distributions = all_distributions();
+    std::vector<size_t> sizes = { 1000, 10000, 100000 };
+    std::vector<Engine> engines = all_engines();
+    unsigned seed = 1;
+    int repeat = 3;
+    CrossingRule rule = CrossingRule::robust;
+    double budget = 60;           //секунд на запуск, дальше этот движок для больших n не запускается
+    size_t check = 2000;          //до какого n сверять жадный с перебором всех пар
+    std::string out;
+};
+
+static void usage() {
+    std::cout << "usage: engine_compare [options]\n"
+        "  --dist LIST        distributions, comma separated: uniform,clustered,grid,collinear,circle (default all)\n"
+        "  --n LIST           point counts, comma separated (default 1000,10000,100000)\n"
+        "  --engine LIST      engines, comma separated: greedy,delaunay,sweep (default all)\n"
+        "  --seed S           generator seed (default 1)\n"
+        "  --repeat R         runs per engine; the fastest is reported (default 3)\n"
+        "  --legacy           legacy crossing test for greedy instead of exact predicates\n"
+        "  --check N          compare greedy with the all-pairs triangulate_mesh for n <= N (default 2000, 0 - off)\n"
+        "  --budget S         skip an engine for larger n once one run took longer than S seconds (default 60)\n"
+        "  --out FILE         write CSV to FILE instead of stdout\n";
+}
+
+static bool parse_list(const std::string& text, std::vector<std::string>& items) {
+    std::stringstream in(text);
+    std::string item;
+    items.clear();
+    while (std::getline(in, item, ',')) {
+        if (item.empty()) {
+            return false;
+        }
+        items.push_back(item);
+    }
+    return !items.empty();
+}
+
+static bool parse_options(int argc, char** argv, CompareOptions& options) {
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = k + 1 < argc;
+        std::vector<std::string> items;
+        if (arg == "--dist" && has_value) {
+            if (!parse_list(argv[++k], items)) {
+                return false;
+            }
+            options.distributions.clear();
+            for (const std::string& name : items) {
+                Distribution d;
+                if (!parse_distribution(name, d)) {
+                    std::cerr << "unknown distribution " << name << "\n";
+                    return false;
+                }
+                options.distributions.push_back(d);
+            }
+        }
+        else if (arg == "--n" && has_value) {
+            if (!parse_list(argv[++k], items)) {
+                return false;
+            }
+            options.sizes.clear();
+            for (const std::string& item : items) {
+                options.sizes.push_back(size_t(std::atof(item.c_str())));
+            }
+        }
+        else if (arg == "--engine" && has_value) {
+            if (!parse_list(argv[++k], items)) {
+                return false;
+            }
+            options.engines.clear();
+            for (const std::string& name : items) {
+                Engine e;
+                if (!parse_engine(name, e)) {
+                    std::cerr << "unknown engine " << name << "\n";
+                    return false;
+                }
+                options.engines.push_back(e);
+            }
+        }
+        else if (arg == "--seed" && has_value) {
+            options.seed = unsigned(std::atol(argv[++k]));
+        }
+        else if (arg == "--repeat" && has_value) {
+            options.repeat = std::max(1, std::atoi(argv[++k]));
+        }
+        else if (arg == "--legacy") {
+            options.rule = CrossingRule::legacy;
+        }
+        else if (arg == "--check" && has_value) {
+            options.check = size_t(std::atof(argv[++k]));
+        }
+        else if (arg == "--budget" && has_value) {
+            options.budget = std::atof(argv[++k]);
+        }
+        else if (arg == "--out" && has_value) {
+            options.out = argv[++k];
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+//принятые рёбра reference (всех пар, с verification) те же и в том же порядке, что edges
+static bool same_accepted(const EdgeList& reference, const EdgeList& edges) {
+    size_t k = 0;
+    for (size_t r = 0; r < reference.size(); r++) {
+        if (!reference.verification[r]) {
+            continue;
+        }
+        if (k == edges.size() || reference.a[r] != edges.a[k] || reference.b[r] != edges.b[k]) {
+            return false;
+        }
+        k++;
+    }
+    return k == edges.size();
+}
+
+
+int main(int argc, char** argv) {
+    CompareOptions options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    std::ofstream file;
+    if (!options.out.empty()) {
+        file.open(options.out, std::ofstream::out | std::ofstream::trunc);
+        if (!file.is_open()) {
+            std::cerr << "error: cannot open " << options.out << "\n";
+            return 1;
+        }
+    }
+    std::ostream& csv = options.out.empty() ? std::cout : file;
+    csv << "distribution,n,engine,edges,length_sum,length_ratio,seconds_min,speedup,same_as_mesh\n";
+
+    //объекты живут всё время: жадный держит буферы между запусками
+    std::stable_partition(options.engines.begin(), options.engines.end(), [](Engine e) { return e == Engine::greedy; });
+    std::vector<std::unique_ptr<Triangulator>> engines;
+    for (Engine e : options.engines) {
+        engines.push_back(make_triangulator(e, options.rule));
+    }
+
+    for (Distribution d : options.distributions) {
+        std::set<Engine> over_budget;
+        for (size_t n : options.sizes) {
+            PointSet points = generate_points(d, n, options.seed);
+            double greedy_length = 0, greedy_seconds = 0;
+            for (auto& engine : engines) {
+                Engine e = engine->engine();
+                if (over_budget.count(e)) {
+                    std::cerr << distribution_name(d) << " n=" << n << " " << engine_name(e) << ": skipped (over budget)\n";
+                    continue;
+                }
+                EdgeList edges;
+                double best = 0;
+                for (int r = 0; r < options.repeat; r++) {
+                    auto start = std::chrono::steady_clock::now();
+                    edges = engine->triangulate(points);
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    best = r == 0 ? seconds : std::min(best, seconds);
+                    if (seconds > options.budget) {
+                        over_budget.insert(e);
+                        break;
+                    }
+                }
+                double length = total_length(points, edges);
+                if (e == Engine::greedy) {
+                    greedy_length = length;
+                    greedy_seconds = best;
+                }
+                csv << distribution_name(d) << "," << n << "," << engine_name(e) << "," << edges.size() << "," << length << ",";
+                if (greedy_length > 0) {
+                    csv << length / greedy_length;
+                }
+                csv << "," << best << ",";
+                if (greedy_seconds > 0 && best > 0) {
+                    csv << greedy_seconds / best;
+                }
+                csv << ",";
+                if (e == Engine::greedy && n <= options.check) {
+                    csv << (same_accepted(triangulate_mesh(points, 0, options.rule), edges) ? 1 : 0);
+                }
+                csv << "\n";
+                csv.flush();
+                std::cerr << distribution_name(d) << " n=" << n << " " << engine_name(e) << ": " << best << " s\n";
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+
+// Постоянный слой (точки и принятые рёбра) плюс одна временная подсветка поверх него.
+// Подсветка рисуется прямо в слой, а перед этим сохраняются только пиксели под ней: в каждой строке -
+// отрезок, куда может попасть толстая линия. Кадр стоит O(длина отрезка * толщина), а не O(число рёбер),
+// O(размер изображения) или O(площадь описанного прямоугольника) у длинной диагонали.
+class OverlayCanvas {
+public:
+    OverlayCanvas(int rows, int cols, const cv::Scalar& background)
+        : layer_(rows, cols, CV_8UC3, background) {}
+
+    // слой; пока есть подсветка - вместе с ней
+    cv::Mat& image() {
+        return layer_;
+    }
+
+    // нарисовать отрезок в постоянный слой
+    void commit_line(const cv::Point& a, const cv::Point& b, const cv::Scalar& color, int thickness) {
+        clear_highlight();
+        cv::line(layer_, a, b, color, thickness);
+    }
+
+    // временно подсветить отрезок; возвращает кадр. Снимается clear_highlight() или следующим вызовом
+    const cv::Mat& highlight(const cv::Point& a, const cv::Point& b, const cv::Scalar& color, int thickness) {
+        clear_highlight();
+        // пиксель линии не дальше thickness / 2 (+1 на растеризацию) от отрезка; r - с запасом
+        const int r = thickness / 2 + 2;
+        const int y_min = std::min(a.y, b.y), y_max = std::max(a.y, b.y);
+        // x точки отрезка на высоте y (y_min <= y <= y_max, отрезок не горизонтальный)
+        auto x_at = [&](int y) {
+            return a.x + double(b.x - a.x) * (y - a.y) / (b.y - a.y);
+        };
+        for (int y = std::max(0, y_min - r); y <= std::min(layer_.rows - 1, y_max + r); y++) {
+            // ближайшая к пикселю строки y точка отрезка лежит в строках [y - r, y + r]
+            double xl = std::min(a.x, b.x), xr = std::max(a.x, b.x);
+            if (a.y != b.y) {
+                int lo = std::max(y_min, y - r), hi = std::min(y_max, y + r);
+                xl = std::min(x_at(lo), x_at(hi));
+                xr = std::max(x_at(lo), x_at(hi));
+            }
+            int x0 = std::max(0, int(std::floor(xl)) - r);
+            int x1 = std::min(layer_.cols - 1, int(std::ceil(xr)) + r);
+            if (x0 > x1) {
+                continue;
+            }
+            spans_.push_back({ y, x0, x1 });
+            const uchar* row = layer_.ptr<uchar>(y);
+            saved_.insert(saved_.end(), row + 3 * x0, row + 3 * (x1 + 1));
+        }
+        cv::line(layer_, a, b, color, thickness);
+        return layer_;
+    }
+
+    // вернуть слой без подсветки
+    void clear_highlight() {
+        const uchar* from = saved_.data();
+        for (const Span& s : spans_) {
+            uchar* row = layer_.ptr<uchar>(s.y);
+            size_t bytes = 3 * size_t(s.x1 - s.x0 + 1);
+            std::copy(from, from + bytes, row + 3 * s.x0);
+            from += bytes;
+        }
+        spans_.clear();
+        saved_.clear();
+    }
+
+private:
+    // сохранённые пиксели строки y, столбцы x0..x1 включительно
+    struct Span {
+        int y, x0, x1;
+    };
+
+    cv::Mat layer_;                 // CV_8UC3
+    std::vector<Span> spans_;
+    std::vector<uchar> saved_;      // их байты подряд
+};
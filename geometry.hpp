@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+#include "predicates.hpp"
+
+
+// точка с координатами типа T: double - основной вариант, int - пиксели в старых программах (course_work*)
+template <class T>
+struct BasicPoint {
+    T x_ = 0;
+    T y_ = 0;
+};
+
+using Point = BasicPoint<double>;
+
+namespace predicates {
+
+inline int orient2d(const Point& a, const Point& b, const Point& c) {
+    return orient2d(a.x_, a.y_, b.x_, b.y_, c.x_, c.y_);
+}
+
+}
+
+
+//пересекает ли отрезок (a, b) отрезок (c, d); общий конец (c или d) пересечением не считается
+inline bool segments_cross(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+    Point crossing;
+    double d = (ax - bx) * (dy - cy) - (ay - by) * (dx - cx);
+    if (d == 0) {
+        return false;
+    }
+    double ua = ((cx - dx) * (ay - cy) - (cy - dy) * (ax - cx)) / d;
+    double ub = ((ax - bx) * (ay - cy) - (ay - by) * (ax - cx)) / d;
+    if (ua < 0 || ua > 1 || ub < 0 || ub > 1) {
+        return false;
+    }
+    crossing.x_ = double(ax + ua * (bx - ax));
+    crossing.y_ = double(ay + ua * (by - ay));
+    if ((crossing.x_ == cx && crossing.y_ == cy) || (crossing.x_ == dx && crossing.y_ == dy)) {
+        return false;
+    }
+    return true;
+}
+
+// пересечение отрезков по выбранному правилу
+inline bool segments_cross(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy,
+                           CrossingRule rule) {
+    if (rule == CrossingRule::robust) {
+        return predicates::segments_conflict(ax, ay, bx, by, cx, cy, dx, dy);
+    }
+    return segments_cross(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+
+template <class T>
+struct BasicEdge {
+    BasicPoint<T> A_;
+    BasicPoint<T> B_;
+
+    bool verification = true;
+
+    BasicEdge() = default;
+
+    BasicEdge(BasicPoint<T> A, BasicPoint<T> B) {
+        A_ = A;
+        B_ = B;
+    }
+
+    double length() const {
+        return sqrt(pow(double(A_.x_) - B_.x_, 2) + pow(double(A_.y_) - B_.y_, 2));
+    }
+
+    //метод проверки на пересечение с другим отрезком
+    //целые координаты - точно, predicates::segments_conflict (целые до 2^53 double представляет без потерь),
+    //float/double - старая проверка через точку пересечения, как раньше (CrossingRule::legacy)
+    bool crosses(const BasicEdge& rhs) const {
+        if constexpr (std::is_integral<T>::value) {
+            return predicates::segments_conflict(double(A_.x_), double(A_.y_), double(B_.x_), double(B_.y_),
+                                                 double(rhs.A_.x_), double(rhs.A_.y_), double(rhs.B_.x_), double(rhs.B_.y_));
+        }
+        else {
+            return segments_cross(A_.x_, A_.y_, B_.x_, B_.y_, rhs.A_.x_, rhs.A_.y_, rhs.B_.x_, rhs.B_.y_);
+        }
+    }
+};
+
+using Edge = BasicEdge<double>;
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define INSTRUMENTATION_RUSAGE 1
+#endif
+
+
+// Счётчики и замеры этапов внутри триангуляции.
+// Собираются только при сборке с -DTRIANGULATION_STATS; без него макросы STATS_COUNT и STATS_STAGE
+// пустые и ничего не стоят. Отчёт - JSON (write_json) и файл событий для chrome://tracing / Perfetto
+// (write_trace). Счётчики у каждого потока свои, сводятся только при чтении отчёта.
+namespace instrumentation {
+
+enum class Counter : int {
+    candidates,      // кандидатов в рёбра создано
+    crosses_calls,   // запросов к индексу рёбер "пересекает ли что-нибудь"
+    segment_tests,   // проверок пары отрезков внутри этих запросов
+    early_exits,     // запросов, остановленных на первом найденном пересечении
+    accepted,        // рёбер принято
+    rejected,        // рёбер отклонено
+    tikz_bytes,      // байт записано в LaTeX
+    count
+};
+
+inline const char* counter_name(Counter c) {
+    static const char* names[] = {
+        "candidates", "crosses_calls", "segment_tests", "early_exits", "accepted", "rejected", "tikz_bytes"
+    };
+    return names[int(c)];
+}
+
+constexpr bool enabled() {
+#ifdef TRIANGULATION_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// пиковая память процесса, КБ (0 - неизвестно)
+inline size_t peak_kb() {
+#ifdef INSTRUMENTATION_RUSAGE
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return size_t(usage.ru_maxrss) / 1024;
+#else
+    return size_t(usage.ru_maxrss);
+#endif
+#else
+    return 0;
+#endif
+}
+
+// один замер этапа
+struct StageRecord {
+    const char* name;
+    uint32_t thread;
+    double start_us;       // от начала работы программы
+    double duration_us;
+    size_t peak_kb;        // пиковая память процесса к концу этапа
+};
+
+class ThreadCounters;
+
+// общее хранилище: замеры этапов и счётчики завершившихся потоков
+class Registry {
+public:
+    static Registry& get() {
+        static Registry registry;
+        return registry;
+    }
+
+    double now_us() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin_).count();
+    }
+
+    void add_stage(const StageRecord& record) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stages_.push_back(record);
+    }
+
+    std::vector<StageRecord> stages() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stages_;
+    }
+
+    // сумма по всем потокам, живым и завершившимся
+    std::vector<uint64_t> counters();
+
+    void reset();
+
+private:
+    friend class ThreadCounters;
+
+    std::mutex mutex_;
+    std::chrono::steady_clock::time_point origin_ = std::chrono::steady_clock::now();
+    std::vector<StageRecord> stages_;
+    std::vector<ThreadCounters*> live_;
+    uint64_t finished_[int(Counter::count)] = {};
+    uint32_t next_thread_ = 0;
+};
+
+// счётчики одного потока: пишет только он сам (без атомарных сложений), читает отчёт
+class ThreadCounters {
+public:
+    ThreadCounters() {
+        Registry& r = Registry::get();
+        std::lock_guard<std::mutex> lock(r.mutex_);
+        id = r.next_thread_++;
+        r.live_.push_back(this);
+    }
+
+    ~ThreadCounters() {
+        Registry& r = Registry::get();
+        std::lock_guard<std::mutex> lock(r.mutex_);
+        for (int c = 0; c < int(Counter::count); c++) {
+            r.finished_[c] += counts[c].load(std::memory_order_relaxed);
+        }
+        r.live_.erase(std::find(r.live_.begin(), r.live_.end(), this));
+    }
+
+    void add(Counter c, uint64_t n) {
+        std::atomic<uint64_t>& value = counts[int(c)];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> counts[int(Counter::count)] = {};
+    uint32_t id = 0;
+};
+
+inline ThreadCounters& local() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+inline std::vector<uint64_t> Registry::counters() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint64_t> sum(finished_, finished_ + int(Counter::count));
+    for (ThreadCounters* t : live_) {
+        for (int c = 0; c < int(Counter::count); c++) {
+            sum[c] += t->counts[c].load(std::memory_order_relaxed);
+        }
+    }
+    return sum;
+}
+
+inline void Registry::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.clear();
+    std::fill(finished_, finished_ + int(Counter::count), 0);
+    for (ThreadCounters* t : live_) {
+        for (auto& value : t->counts) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+inline void add(Counter c, uint64_t n) {
+    local().add(c, n);
+}
+
+// замер этапа от создания до конца области видимости
+class ScopedStage {
+public:
+    explicit ScopedStage(const char* name)
+        : name_(name), start_(Registry::get().now_us()) {}
+
+    ~ScopedStage() {
+        Registry& r = Registry::get();
+        r.add_stage({ name_, local().id, start_, r.now_us() - start_, peak_kb() });
+    }
+
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+private:
+    const char* name_;
+    double start_;
+};
+
+// {"enabled", "counters", "stages" (время и число запусков по имени), "timeline" (все замеры), "peak_kb"}
+inline void write_json(std::ostream& out) {
+    out << "{\n  \"enabled\": " << (enabled() ? "true" : "false");
+    if (enabled()) {
+        Registry& r = Registry::get();
+        std::vector<uint64_t> counts = r.counters();
+        out << ",\n  \"counters\": {";
+        for (int c = 0; c < int(Counter::count); c++) {
+            out << (c ? ", " : "") << "\"" << counter_name(Counter(c)) << "\": " << counts[c];
+        }
+        out << "},\n";
+
+        std::vector<StageRecord> stages = r.stages();
+        std::vector<std::string> names;
+        for (const StageRecord& s : stages) {
+            if (std::find(names.begin(), names.end(), s.name) == names.end()) {
+                names.push_back(s.name);
+            }
+        }
+        out << "  \"stages\": {";
+        for (size_t k = 0; k < names.size(); k++) {
+            double seconds = 0;
+            size_t runs = 0, peak = 0;
+            for (const StageRecord& s : stages) {
+                if (names[k] == s.name) {
+                    seconds += s.duration_us / 1e6;
+                    runs++;
+                    peak = std::max(peak, s.peak_kb);
+                }
+            }
+            out << (k ? ",\n    " : "\n    ") << "\"" << names[k] << "\": {\"seconds\": " << seconds
+                << ", \"runs\": " << runs << ", \"peak_kb\": " << peak << "}";
+        }
+        out << "\n  },\n  \"timeline\": [";
+        for (size_t k = 0; k < stages.size(); k++) {
+            const StageRecord& s = stages[k];
+            out << (k ? ",\n    " : "\n    ") << "{\"name\": \"" << s.name << "\", \"thread\": " << s.thread
+                << ", \"start_ms\": " << s.start_us / 1000 << ", \"seconds\": " << s.duration_us / 1e6
+                << ", \"peak_kb\": " << s.peak_kb << "}";
+        }
+        out << "\n  ],\n  \"peak_kb\": " << peak_kb();
+    }
+    out << "\n}\n";
+}
+
+// файл событий Chrome (Trace Event Format): этапы - отрезки на линиях потоков, счётчики - в конце
+inline void write_trace(std::ostream& out) {
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    if (enabled()) {
+        Registry& r = Registry::get();
+        std::vector<StageRecord> stages = r.stages();
+        double end = 0;
+        for (size_t k = 0; k < stages.size(); k++) {
+            const StageRecord& s = stages[k];
+            out << (k ? ",\n" : "\n") << "{\"name\": \"" << s.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                << s.thread << ", \"ts\": " << s.start_us << ", \"dur\": " << s.duration_us
+                << ", \"args\": {\"peak_kb\": " << s.peak_kb << "}}";
+            end = std::max(end, s.start_us + s.duration_us);
+        }
+        std::vector<uint64_t> counts = r.counters();
+        out << (stages.empty() ? "\n" : ",\n") << "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << end
+            << ", \"args\": {";
+        for (int c = 0; c < int(Counter::count); c++) {
+            out << (c ? ", " : "") << "\"" << counter_name(Counter(c)) << "\": " << counts[c];
+        }
+        out << "}}";
+    }
+    out << "\n]}\n";
+}
+
+}
+
+#define STATS_CONCAT_(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+
+#ifdef TRIANGULATION_STATS
+// прибавить n к счётчику instrumentation::Counter::counter
+#define STATS_COUNT(counter, n) ::instrumentation::add(::instrumentation::Counter::counter, uint64_t(n))
+// замерить этап до конца текущего блока
+#define STATS_STAGE(name) ::instrumentation::ScopedStage STATS_CONCAT(stats_stage_, __LINE__)(name)
+#else
+#define STATS_COUNT(counter, n) ((void)0)
+#define STATS_STAGE(name) ((void)0)
+#endif
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include "mesh.hpp"
+#include "predicates.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <cerrno>
+#define JOB_PROTOCOL_POSIX 1
+#endif
+
+
+// Кадры для режима сервера (stdin/stdout или Unix-сокет). Числа - в порядке байт машины,
+// как в .gtri: клиент и сервер работают на одной машине.
+//   кадр:    uint32 длина тела, тело; кадр нулевой длины - конец работы
+//   запрос:  uint64 id, uint32 flags (бит 0 - CrossingRule::robust), uint32 n, n пар double (x, y)
+//   ответ:   uint64 id, uint32 status, uint32 m, затем
+//            status == 0: m пар uint32 (i, j) - принятые рёбра в порядке принятия
+//            status == 1: m байт текста ошибки
+// Ответы приходят в порядке готовности, а не в порядке запросов: сопоставлять надо по id.
+namespace job_protocol {
+
+const uint32_t kMaxFrame = 1u << 30;
+const uint32_t kRobust = 1;
+const uint32_t kOk = 0;
+const uint32_t kError = 1;
+
+template <class T>
+void put(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <class T>
+T get(const std::vector<char>& in, size_t& at) {
+    if (in.size() - at < sizeof(T)) {
+        throw std::runtime_error("truncated frame");
+    }
+    T value;
+    std::memcpy(&value, in.data() + at, sizeof(T));
+    at += sizeof(T);
+    return value;
+}
+
+// тело запроса (без длины кадра)
+inline void encode_request(uint64_t id, CrossingRule rule, const PointSet& points, std::vector<char>& out) {
+    out.clear();
+    out.reserve(16 + 16 * points.size());
+    put(out, id);
+    put(out, uint32_t(rule == CrossingRule::robust ? kRobust : 0));
+    put(out, uint32_t(points.size()));
+    for (size_t i = 0; i < points.size(); i++) {
+        put(out, points.xs[i]);
+        put(out, points.ys[i]);
+    }
+}
+
+// разбор запроса в points (память points переиспользуется); исключение - кадр испорчен
+inline uint64_t decode_request(const std::vector<char>& in, CrossingRule& rule, PointSet& points) {
+    size_t at = 0;
+    uint64_t id = get<uint64_t>(in, at);
+    uint32_t flags = get<uint32_t>(in, at);
+    uint32_t n = get<uint32_t>(in, at);
+    if ((in.size() - at) / 16 != n || (in.size() - at) % 16 != 0) {
+        throw std::runtime_error("point count does not match frame size");
+    }
+    rule = flags & kRobust ? CrossingRule::robust : CrossingRule::legacy;
+    points.xs.resize(n);
+    points.ys.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        points.xs[i] = get<double>(in, at);
+        points.ys[i] = get<double>(in, at);
+    }
+    return id;
+}
+
+// тело ответа: pairs - подряд идущие i, j
+inline void encode_edges(uint64_t id, const std::vector<uint32_t>& pairs, std::vector<char>& out) {
+    out.clear();
+    out.reserve(16 + 4 * pairs.size());
+    put(out, id);
+    put(out, kOk);
+    put(out, uint32_t(pairs.size() / 2));
+    const char* bytes = reinterpret_cast<const char*>(pairs.data());
+    out.insert(out.end(), bytes, bytes + 4 * pairs.size());
+}
+
+inline void encode_error(uint64_t id, const std::string& message, std::vector<char>& out) {
+    out.clear();
+    put(out, id);
+    put(out, kError);
+    put(out, uint32_t(message.size()));
+    out.insert(out.end(), message.begin(), message.end());
+}
+
+// разбор ответа: status == kOk - рёбра в pairs, иначе текст в message
+inline uint64_t decode_response(const std::vector<char>& in, uint32_t& status, std::vector<uint32_t>& pairs,
+                                std::string& message) {
+    size_t at = 0;
+    uint64_t id = get<uint64_t>(in, at);
+    status = get<uint32_t>(in, at);
+    uint32_t m = get<uint32_t>(in, at);
+    if (status == kOk) {
+        if ((in.size() - at) / 8 != m || (in.size() - at) % 8 != 0) {
+            throw std::runtime_error("edge count does not match frame size");
+        }
+        pairs.resize(2 * size_t(m));
+        std::memcpy(pairs.data(), in.data() + at, 8 * size_t(m));
+    }
+    else {
+        if (in.size() - at != m) {
+            throw std::runtime_error("message size does not match frame size");
+        }
+        message.assign(in.data() + at, m);
+    }
+    return id;
+}
+
+#ifdef JOB_PROTOCOL_POSIX
+
+// false - конец потока (или ошибка) до того, как прочитано size байт
+inline bool read_full(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t got = ::read(fd, p, size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        p += got;
+        size -= size_t(got);
+    }
+    return true;
+}
+
+inline bool write_full(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t put = ::write(fd, p, size);
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put <= 0) {
+            return false;
+        }
+        p += put;
+        size -= size_t(put);
+    }
+    return true;
+}
+
+// следующий кадр в body; false - конец потока или кадр нулевой длины. Слишком длинный кадр - исключение
+inline bool read_frame(int fd, std::vector<char>& body) {
+    uint32_t size = 0;
+    if (!read_full(fd, &size, sizeof(size)) || size == 0) {
+        return false;
+    }
+    if (size > kMaxFrame) {
+        throw std::runtime_error("frame too large");
+    }
+    body.resize(size);
+    return read_full(fd, body.data(), size);
+}
+
+// кадр целиком; если пишут несколько потоков - под общим мьютексом
+inline bool write_frame(int fd, const std::vector<char>& body) {
+    uint32_t size = uint32_t(body.size());
+    return write_full(fd, &size, sizeof(size)) && write_full(fd, body.data(), body.size());
+}
+
+// кадр конца работы
+inline bool write_end(int fd) {
+    uint32_t size = 0;
+    return write_full(fd, &size, sizeof(size));
+}
+
+#endif
+
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <type_traits>
+#include <stdexcept>
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "segment_index.hpp"
+#include "edge_sort.hpp"
+#include "triangulate.hpp"
+
+
+namespace lazy_detail {
+
+// порядок кучи: наверху наименьшая пара по candidate_less
+inline bool heap_less(const CandidateEdge& l, const CandidateEdge& r) {
+    return candidate_less(r, l);
+}
+
+// Пары (i, j), i < j, по требованию в порядке (длина, i, j), без списка всех пар.
+// У точки i курсор (greedy_detail::PairCursor): радиус поиска reach и до kBatch следующих пар - наименьших
+// после последней выданной среди точек j > i не дальше reach (в квадрате со стороной 2 reach вокруг i).
+// Если там ничего не осталось, в кучу кладётся заглушка (reach, i, kNone): радиус удвоится, только когда
+// до пар такой длины дойдёт очередь, - к тому времени точка обычно уже выбыла, и дальние точки
+// не перебираются вовсе. Курсоры сливаются кучей, в которой по одной паре (или заглушке) на точку.
+class PairCursors {
+public:
+    // alive[q] == 0 - точка q выбыла, пар с ней больше не нужно
+    PairCursors(const PointSet& points, const UniformGrid& grid, const greedy_detail::PointBuckets& buckets,
+                const std::vector<char>& alive, std::vector<CandidateEdge>& heap,
+                std::vector<greedy_detail::PairCursor>& cursors)
+        : p_(points), grid_(grid), buckets_(buckets), alive_(alive), heap_(heap), cursors_(cursors) {
+        const uint32_t n = uint32_t(points.size());
+        diagonal_ = grid.diagonal();
+        heap_.clear();
+        heap_.reserve(n);
+        cursors_.resize(n);
+        for (uint32_t i = 0; i < n; i++) {
+            cursors_[i].reach = grid.cell;
+            refill(i, { -1, i, i });
+            push(i);
+        }
+    }
+
+    // следующая пара с живой первой точкой; false - пар больше нет
+    bool next(CandidateEdge& e) {
+        while (!heap_.empty()) {
+            std::pop_heap(heap_.begin(), heap_.end(), heap_less);
+            e = heap_.back();
+            heap_.pop_back();
+            greedy_detail::PairCursor& cur = cursors_[e.i];
+            if (!alive_[e.i]) {
+                continue;
+            }
+            if (e.j == greedy_detail::kNone) {
+                cur.reach *= 2;
+                refill(e.i, e);
+                push(e.i);
+                continue;
+            }
+            // запас кончился, но радиус им исчерпан не был - смотрим тот же квадрат дальше
+            if (cur.pos == cur.size && cur.size == greedy_detail::PairCursor::kBatch) {
+                refill(e.i, e);
+            }
+            push(e.i);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    // до kBatch наименьших пар точки last.i после last в пределах радиуса
+    void refill(uint32_t i, const CandidateEdge& last) {
+        const int batch = greedy_detail::PairCursor::kBatch;
+        greedy_detail::PairCursor& cur = cursors_[i];
+        const double px = p_.xs[i], py = p_.ys[i], reach = cur.reach;
+        CandidateEdge best[batch];
+        int size = 0;
+        for (int r = grid_.row(py - reach); r <= grid_.row(py + reach); r++) {
+            double y0 = grid_.min_y + r * grid_.cell;
+            double dy = std::max(std::fabs(py - y0), std::fabs(py - y0 - grid_.cell));
+            for (int c = grid_.col(px - reach); c <= grid_.col(px + reach); c++) {
+                // ячейка целиком ближе последней выданной пары - всё в ней уже выдано (с запасом на
+                // округление; в крайние ячейки прижаты и точки за краем сетки, их не пропускаем)
+                double x0 = grid_.min_x + c * grid_.cell;
+                double dx = std::max(std::fabs(px - x0), std::fabs(px - x0 - grid_.cell));
+                bool inner = r > 0 && r + 1 < grid_.rows && c > 0 && c + 1 < grid_.cols;
+                if (inner && sqrt(dx * dx + dy * dy) < last.len * (1 - 1e-9)) {
+                    continue;
+                }
+                int cell = grid_.index(c, r);
+                for (uint32_t k = buckets_.start[cell]; k < buckets_.start[cell + 1]; k++) {
+                    uint32_t q = buckets_.items[k];
+                    if (q <= i || !alive_[q]) {
+                        continue;
+                    }
+                    CandidateEdge e = { p_.length(i, q), i, q };
+                    if (e.len > reach || !candidate_less(last, e) || (size == batch && !candidate_less(e, best[batch - 1]))) {
+                        continue;
+                    }
+                    // вставка в упорядоченный запас
+                    int at = size < batch ? size++ : batch - 1;
+                    for (; at > 0 && candidate_less(e, best[at - 1]); at--) {
+                        best[at] = best[at - 1];
+                    }
+                    best[at] = e;
+                }
+            }
+        }
+        for (int k = 0; k < size; k++) {
+            cur.next[k] = best[k].j;
+        }
+        cur.size = uint8_t(size);
+        cur.pos = 0;
+    }
+
+    // в кучу - очередная пара из запаса или заглушка; если пар нет совсем, курсор закрывается
+    void push(uint32_t i) {
+        greedy_detail::PairCursor& cur = cursors_[i];
+        if (cur.pos < cur.size) {
+            uint32_t q = cur.next[cur.pos++];
+            heap_.push_back({ p_.length(i, q), i, q });
+        }
+        else if (cur.reach > diagonal_) {
+            return;
+        }
+        else {
+            heap_.push_back({ cur.reach, i, greedy_detail::kNone });
+        }
+        std::push_heap(heap_.begin(), heap_.end(), heap_less);
+    }
+
+    const PointSet& p_;
+    const UniformGrid& grid_;
+    const greedy_detail::PointBuckets& buckets_;
+    const std::vector<char>& alive_;
+    std::vector<CandidateEdge>& heap_;
+    std::vector<greedy_detail::PairCursor>& cursors_;
+    double diagonal_ = 0;
+};
+
+// есть ли совпадающие точки (они лежат в одной ячейке)
+inline bool has_duplicates(const PointSet& points, const greedy_detail::PointBuckets& buckets) {
+    for (size_t c = 0; c + 1 < buckets.start.size(); c++) {
+        for (uint32_t a = buckets.start[c]; a < buckets.start[c + 1]; a++) {
+            for (uint32_t b = a + 1; b < buckets.start[c + 1]; b++) {
+                uint32_t i = buckets.items[a], j = buckets.items[b];
+                if (points.xs[i] == points.xs[j] && points.ys[i] == points.ys[j]) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+}
+
+
+// Жадная триангуляция с ленивым перебором пар: кандидаты берутся из курсоров ближайших соседей
+// (lazy_detail::PairCursors) по одному, в том же порядке (длина, номера), что и у triangulate().
+// Точка выбывает, как только её веер закрыт (как в triangulate_fast_stream), и её курсор закрывается.
+// Проход кончается, когда пар не осталось или - для CrossingRule::robust без совпадающих точек -
+// как только принято 3n - 3 - h рёбер (h - точек на границе оболочки): триангуляция полна.
+// В отличие от triangulate_fast_stream, здесь нет полос: в памяти всегда O(n), даже когда на последних
+// шагах живых точек много и они далеко друг от друга (точки на одной прямой).
+// sink(i, j, accepted) получает каждую проверенную пару; пары с выбывшей точкой не проверяются
+// (для robust они заведомо отклонены). Принятые совпадают с рёбрами triangulate_fast_stream().
+template <class Sink>
+void triangulate_lazy_stream(const PointSet& points, Sink&& sink, CrossingRule rule,
+                             TriangulationWorkspace& workspace) {
+    using namespace greedy_detail;
+    STATS_STAGE("lazy");
+
+    const uint32_t n = uint32_t(points.size());
+    if (n < 2) {
+        return;
+    }
+
+    UniformGrid grid(points, 2.0);
+    PointBuckets& buckets = workspace.buckets;
+    buckets.build(grid, points);
+    SegmentIndex& accepted = workspace.accepted;
+    accepted.reset(grid, rule);
+    accepted.reserve(3 * size_t(n));
+
+    std::vector<uint32_t>& hull_prev = workspace.hull_prev;
+    std::vector<uint32_t>& hull_next = workspace.hull_next;
+    hull_prev.assign(n, kNone);
+    hull_next.assign(n, kNone);
+    hull_links(points, grid, buckets, hull_prev, hull_next);
+
+    // сколько рёбер у полной триангуляции, если это число известно заранее
+    size_t complete = std::numeric_limits<size_t>::max();
+    size_t on_hull = size_t(std::count_if(hull_next.begin(), hull_next.end(), [](uint32_t q) { return q != kNone; }));
+    if (rule == CrossingRule::robust && on_hull >= 3 && !lazy_detail::has_duplicates(points, buckets)) {
+        complete = 3 * size_t(n) - 3 - on_hull;
+    }
+
+    workspace.arena.reset();
+    workspace.arena.reserve(NeighbourLists::bytes(n));
+    NeighbourLists adj;
+    adj.assign(workspace.arena, n);
+    std::vector<char>& alive = workspace.alive;
+    alive.assign(n, 1);
+
+    auto has_edge = [&](uint32_t a, uint32_t b) {
+        return adj.contains(a, b);
+    };
+    const double inf = std::numeric_limits<double>::infinity();
+    auto retire = [&](uint32_t p) {
+        if (alive[p] && fan_radius(points, p, adj[p], has_edge, workspace.around, hull_prev[p], hull_next[p]) != inf) {
+            alive[p] = 0;
+        }
+    };
+
+    lazy_detail::PairCursors cursors(points, grid, buckets, alive, workspace.candidates, workspace.cursors);
+    size_t count = 0;
+    CandidateEdge c;
+    while (count < complete && cursors.next(c)) {
+        if (!alive[c.j]) {
+            continue;
+        }
+        Point A = points[c.i];
+        Point B = points[c.j];
+        if (accepted.crosses_any(A, B)) {
+            STATS_COUNT(rejected, 1);
+            sink(c.i, c.j, false);
+            continue;
+        }
+        STATS_COUNT(accepted, 1);
+        count++;
+        accepted.insert(A, B);
+        sink(c.i, c.j, true);
+        adj.push_back(c.i, c.j);
+        adj.push_back(c.j, c.i);
+        retire(c.i);
+        retire(c.j);
+        for (uint32_t x : adj[c.i]) {
+            if (has_edge(x, c.j)) {
+                retire(x);
+            }
+        }
+    }
+}
+
+template <class Sink>
+void triangulate_lazy_stream(const PointSet& points, Sink&& sink, CrossingRule rule = CrossingRule::robust) {
+    TriangulationWorkspace workspace;
+    triangulate_lazy_stream(points, sink, rule, workspace);
+}
+
+// проверенные пары по порядку, с verification - для визуализации: шаги те же, что у triangulate_mesh(),
+// только без пар, которые заведомо ничего не дают (с выбывшей точкой и после полной триангуляции)
+inline EdgeList triangulate_lazy_mesh(const PointSet& points, CrossingRule rule = CrossingRule::robust) {
+    EdgeList result;
+    result.reserve(4 * points.size());
+    triangulate_lazy_stream(points, [&](uint32_t i, uint32_t j, bool ok) { result.push_back(i, j, ok); }, rule);
+    return result;
+}
+
+inline std::vector<Edge> triangulate_lazy(const std::vector<Point>& points, CrossingRule rule = CrossingRule::robust) {
+    Mesh mesh;
+    mesh.points = PointSet(points);
+    mesh.edges = triangulate_lazy_mesh(mesh.points, rule);
+    return mesh.to_edges();
+}
+
+//triangulate() для точек с координатами любого типа: шаги по порядку, с verification. Целые до 2^53 по модулю
+//double представляет без потерь, поэтому они всегда считаются точными предикатами и ленивым перебором пар,
+//без списка всех n(n - 1)/2 пар (порядок по длине точен, пока квадраты длин меньше 2^53 - для пикселей всегда);
+//большие целые - std::invalid_argument. Прочие (float) - через double, проверку выбирает rule;
+//с robust - тоже лениво, с legacy - все пары, как у triangulate_mesh.
+//Для double берётся обычный triangulate() (triangulate.hpp).
+template <class T>
+std::vector<BasicEdge<T>> triangulate(const std::vector<BasicPoint<T>>& points, unsigned threads = 0,
+                                      CrossingRule rule = CrossingRule::legacy) {
+    if constexpr (std::is_integral<T>::value) {
+        const long double limit = 9007199254740992.0L;   // 2^53
+        for (const BasicPoint<T>& p : points) {
+            if (std::fabs((long double)p.x_) > limit || std::fabs((long double)p.y_) > limit) {
+                throw std::invalid_argument("triangulate: integer coordinates beyond 2^53");
+            }
+        }
+        rule = CrossingRule::robust;
+    }
+    PointSet set;
+    set.reserve(points.size());
+    for (const BasicPoint<T>& p : points) {
+        set.push_back(double(p.x_), double(p.y_));
+    }
+    EdgeList edges = rule == CrossingRule::robust ? triangulate_lazy_mesh(set, rule)
+                                                  : triangulate_mesh(set, threads, rule);
+    std::vector<BasicEdge<T>> result;
+    result.reserve(edges.size());
+    for (size_t k = 0; k < edges.size(); k++) {
+        result.push_back(BasicEdge<T>(points[edges.a[k]], points[edges.b[k]]));
+        result.back().verification = edges.verification[k];
+    }
+    return result;
+}
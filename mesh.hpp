@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include "geometry.hpp"
+
+
+// точки храним один раз, отдельными массивами координат
+struct PointSet {
+    std::vector<double> xs;
+    std::vector<double> ys;
+
+    PointSet() = default;
+
+    explicit PointSet(const std::vector<Point>& points) {
+        reserve(points.size());
+        for (const Point& p : points) {
+            push_back(p.x_, p.y_);
+        }
+    }
+
+    size_t size() const {
+        return xs.size();
+    }
+
+    void reserve(size_t n) {
+        xs.reserve(n);
+        ys.reserve(n);
+    }
+
+    void push_back(double x, double y) {
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+
+    Point operator[](uint32_t i) const {
+        Point p;
+        p.x_ = xs[i];
+        p.y_ = ys[i];
+        return p;
+    }
+
+    // то же выражение, что и в Edge::length()
+    double length(uint32_t i, uint32_t j) const {
+        return sqrt(pow(xs[i] - xs[j], 2) + pow(ys[i] - ys[j], 2));
+    }
+
+    // то же, что Edge(i, j).crosses(Edge(k, l))
+    bool crosses(uint32_t i, uint32_t j, uint32_t k, uint32_t l) const {
+        return segments_cross(xs[i], ys[i], xs[j], ys[j], xs[k], ys[k], xs[l], ys[l]);
+    }
+};
+
+
+// рёбра - пары номеров точек, признак verification хранится отдельной битовой маской
+struct EdgeList {
+    std::vector<uint32_t> a;
+    std::vector<uint32_t> b;
+    std::vector<bool> verification;
+
+    size_t size() const {
+        return a.size();
+    }
+
+    void reserve(size_t n) {
+        a.reserve(n);
+        b.reserve(n);
+        verification.reserve(n);
+    }
+
+    void push_back(uint32_t i, uint32_t j, bool ok = true) {
+        a.push_back(i);
+        b.push_back(j);
+        verification.push_back(ok);
+    }
+};
+
+
+struct Mesh {
+    PointSet points;
+    EdgeList edges;
+
+    Edge edge(uint32_t k) const {
+        Edge e(points[edges.a[k]], points[edges.b[k]]);
+        e.verification = edges.verification[k];
+        return e;
+    }
+
+    // список рёбер в старом виде (с копиями точек) - для кода, который работает с Edge
+    std::vector<Edge> to_edges() const {
+        std::vector<Edge> result;
+        result.reserve(edges.size());
+        for (uint32_t k = 0; k < edges.size(); k++) {
+            result.push_back(edge(k));
+        }
+        return result;
+    }
+};
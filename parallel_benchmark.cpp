@@ -0,0 +1,64 @@
+// Замер ускорения triangulate_parallel_mesh относительно последовательной triangulate_mesh.
+// Запуск: parallel_benchmark [число точек] [макс. число потоков] [seed]
+// Для каждого числа потоков 1, 2, 4, ... печатает время, ускорение и совпадение результата с последовательным.
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "parallel_greedy.hpp"
+
+
+static bool same_edges(const EdgeList& l, const EdgeList& r) {
+    return l.a == r.a && l.b == r.b && l.verification == r.verification;
+}
+
+template <class F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 2000;
+    unsigned max_threads = argc > 2 ? unsigned(std::stoul(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+    unsigned seed = argc > 3 ? unsigned(std::stoul(argv[3])) : 1;
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> coord(0, 1000);
+    PointSet points;
+    points.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        double x = coord(gen);
+        points.push_back(x, coord(gen));
+    }
+
+    EdgeList reference;
+    double base = seconds([&] { reference = triangulate_mesh(points, 1); });
+    std::cout << "points: " << n << ", candidates: " << reference.size() << "\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "triangulate (1 thread): " << base << " s\n";
+    std::cout << "threads\ttime, s\tspeedup\tidentical\n";
+
+    bool ok = true;
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < max_threads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(max_threads);
+
+    for (unsigned t : counts) {
+        EdgeList edges;
+        double time = seconds([&] { edges = triangulate_parallel_mesh(points, t); });
+        bool same = same_edges(edges, reference);
+        ok = ok && same;
+        std::cout << t << "\t" << time << "\t" << base / time << "\t" << (same ? "yes" : "NO") << "\n";
+    }
+    return ok ? 0 : 1;
+}
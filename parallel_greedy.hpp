@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "segment_index.hpp"
+#include "edge_sort.hpp"
+#include "predicates.hpp"
+#include "worker_pool.hpp"
+
+
+// Жадная триангуляция с пакетным (спекулятивным) принятием рёбер.
+// Кандидаты идут в том же порядке, что и в triangulate_mesh(), но пачками по batch штук:
+//  1) все кандидаты пачки параллельно проверяются по рёбрам, принятым до пачки (индекс в это время только читается);
+//     кто пересёк хотя бы одно - отклонён и при последовательной проверке был бы отклонён тоже;
+//  2) уцелевшие по порядку длины проверяются только по рёбрам, принятым внутри этой же пачки, и вставляются.
+// Итог в точности совпадает с triangulate_mesh() при любом числе потоков и размере пачки.
+// threads - число потоков (0 - по числу ядер), batch - размер пачки (0 - подобрать по числу потоков).
+inline EdgeList triangulate_parallel_mesh(const PointSet& points, unsigned threads = 0,
+                                          CrossingRule rule = CrossingRule::legacy, size_t batch = 0) {
+    EdgeList result;
+    const uint32_t n = uint32_t(points.size());
+    if (n < 2) {
+        return result;
+    }
+
+    WorkerPool pool(threads);
+    if (batch == 0) {
+        batch = 2048 * size_t(pool.size());
+    }
+
+    // строка i занимает места с i * (2n - i - 1) / 2, поэтому строки заполняются независимо
+    std::vector<CandidateEdge> edges(size_t(n) * (n - 1) / 2);
+    {
+        STATS_STAGE("candidates");
+        pool.parallel_for(n - 1, [&](size_t i) {
+            size_t at = i * (2 * size_t(n) - i - 1) / 2;
+            for (uint32_t j = uint32_t(i) + 1; j < n; j++) {
+                edges[at++] = { points.length(uint32_t(i), j), uint32_t(i), j };
+            }
+        }, 16);
+        STATS_COUNT(candidates, edges.size());
+    }
+
+    sort_candidates(edges, pool.size());
+
+    STATS_STAGE("filter");
+    SegmentIndex accepted(UniformGrid(points, 2.0), rule);
+    result.a.resize(edges.size());
+    result.b.resize(edges.size());
+    result.verification.resize(edges.size());
+    std::vector<char> maybe(batch);
+
+    for (size_t begin = 0; begin < edges.size(); begin += batch) {
+        const size_t count = std::min(batch, edges.size() - begin);
+        pool.parallel_for(count, [&](size_t k) {
+            const CandidateEdge& e = edges[begin + k];
+            maybe[k] = !accepted.crosses_any(points[e.i], points[e.j]);
+        });
+
+        const uint32_t first = uint32_t(accepted.size());
+        for (size_t k = 0; k < count; k++) {
+            const CandidateEdge& e = edges[begin + k];
+            Point A = points[e.i];
+            Point B = points[e.j];
+            bool ok = maybe[k] && !accepted.crosses_any(A, B, first);
+            if (ok) {
+                accepted.insert(A, B);
+            }
+            result.a[begin + k] = e.i;
+            result.b[begin + k] = e.j;
+            result.verification[begin + k] = ok;
+        }
+    }
+    STATS_COUNT(accepted, accepted.size());
+    STATS_COUNT(rejected, edges.size() - accepted.size());
+    return result;
+}
+
+inline std::vector<Edge> triangulate_parallel(const std::vector<Point>& points, unsigned threads = 0,
+                                              CrossingRule rule = CrossingRule::legacy) {
+    Mesh mesh;
+    mesh.points = PointSet(points);
+    mesh.edges = triangulate_parallel_mesh(mesh.points, threads, rule);
+    return mesh.to_edges();
+}
@@ -0,0 +1,122 @@
+// Перевод файлов точек между текстовым форматом ("n x1 y1 ...") и двоичным (binary_format.hpp).
+// Направление определяется по входному файлу: двоичный узнаётся по подписи.
+//   point_convert points.txt points.gtri [--int32] [--edges edges.txt]
+//       текст -> двоичный; --int32 - хранить целые координаты как int32,
+//       --edges - добавить рёбра из текстового файла (строки "i j" или "i j verification")
+//   point_convert points.gtri points.txt [--edges edges.txt]
+//       двоичный -> текст; --edges - куда выписать рёбра (если они есть в файле)
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <charconv>
+#include <stdexcept>
+#include "mesh.hpp"
+#include "point_io.hpp"
+#include "binary_format.hpp"
+
+using namespace binary_format;
+
+
+// текстовые рёбра: по строке "i j" или "i j verification"
+static void read_edges(const std::string& path, BinaryWriter& writer, size_t point_count) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::string line;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        std::istringstream fields(line);
+        std::string field;
+        uint64_t values[3];
+        int count = 0;
+        while (fields >> field) {
+            auto r = std::from_chars(field.data(), field.data() + field.size(), values[count < 3 ? count : 2]);
+            if (r.ec != std::errc() || r.ptr != field.data() + field.size() || ++count > 3) {
+                throw std::runtime_error(path + ":" + std::to_string(number) + ": bad edge line");
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+        if (count == 1 || values[0] >= point_count || values[1] >= point_count) {
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": bad edge line");
+        }
+        if (count == 3) {
+            writer.push_back(uint32_t(values[0]), uint32_t(values[1]), values[2] != 0);
+        }
+        else {
+            writer.push_back(uint32_t(values[0]), uint32_t(values[1]));
+        }
+    }
+}
+
+static void write_edges(const std::string& path, const MappedMesh& mesh) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    for (size_t k = 0; k < mesh.edge_count(); k++) {
+        out << mesh.edges()[2 * k] << " " << mesh.edges()[2 * k + 1];
+        if (mesh.has_verification()) {
+            out << " " << mesh.verification(k);
+        }
+        out << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "usage: point_convert <in> <out> [--int32] [--edges <file>]\n";
+        return 2;
+    }
+    std::string input = argv[1];
+    std::string output = argv[2];
+    bool int32 = false;
+    std::string edges;
+    for (int k = 3; k < argc; k++) {
+        std::string arg = argv[k];
+        if (arg == "--int32") {
+            int32 = true;
+        }
+        else if (arg == "--edges" && k + 1 < argc) {
+            edges = argv[++k];
+        }
+        else {
+            std::cout << "unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+
+    try {
+        if (is_binary(input)) {
+            MappedMesh mesh(input);
+            std::ofstream out(output, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                throw std::runtime_error("cannot open " + output);
+            }
+            write_points(out, mesh.points());
+            if (!edges.empty()) {
+                write_edges(edges, mesh);
+            }
+            std::cout << mesh.point_count() << " points, " << mesh.edge_count() << " edges -> " << output << "\n";
+        }
+        else {
+            PointSet points = read_points(input);
+            BinaryWriter writer(output, points, int32 ? CoordType::int32 : CoordType::float64);
+            if (!edges.empty()) {
+                read_edges(edges, writer, points.size());
+            }
+            writer.finish();
+            std::cout << points.size() << " points -> " << output << "\n";
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
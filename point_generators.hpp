@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include "mesh.hpp"
+
+
+// Синтетические наборы точек для замеров. Точки лежат в прямоугольнике [0, width] x [0, height]
+// (по умолчанию - размер окна отрисовки), один и тот же seed даёт один и тот же набор.
+enum class Distribution {
+    uniform,     // равномерно по прямоугольнику
+    clustered,   // нормальные облака вокруг ~sqrt(n)/2 случайных центров
+    grid,        // узлы квадратной решётки: много равных длин и точек на одной прямой
+    collinear,   // 90% точек на горизонтальных и вертикальных прямых (точно на одной прямой), 10% - шум
+    circle       // правильный n-угольник: все точки на одной окружности, длины повторяются
+};
+
+inline const std::vector<Distribution>& all_distributions() {
+    static const std::vector<Distribution> all = {
+        Distribution::uniform, Distribution::clustered, Distribution::grid,
+        Distribution::collinear, Distribution::circle
+    };
+    return all;
+}
+
+inline const char* distribution_name(Distribution d) {
+    switch (d) {
+    case Distribution::uniform: return "uniform";
+    case Distribution::clustered: return "clustered";
+    case Distribution::grid: return "grid";
+    case Distribution::collinear: return "collinear";
+    case Distribution::circle: return "circle";
+    }
+    return "?";
+}
+
+// false - нет такого распределения
+inline bool parse_distribution(const std::string& name, Distribution& d) {
+    for (Distribution x : all_distributions()) {
+        if (name == distribution_name(x)) {
+            d = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline PointSet generate_points(Distribution d, size_t n, unsigned seed = 1,
+                                double width = 1400, double height = 800) {
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> x_coord(0, width);
+    std::uniform_real_distribution<double> y_coord(0, height);
+    PointSet points;
+    points.reserve(n);
+
+    switch (d) {
+    case Distribution::uniform:
+        for (size_t i = 0; i < n; i++) {
+            double x = x_coord(gen);
+            points.push_back(x, y_coord(gen));
+        }
+        break;
+
+    case Distribution::clustered: {
+        size_t clusters = std::max<size_t>(1, size_t(sqrt(double(n)) / 2));
+        std::vector<double> cx(clusters), cy(clusters);
+        for (size_t k = 0; k < clusters; k++) {
+            cx[k] = x_coord(gen);
+            cy[k] = y_coord(gen);
+        }
+        std::normal_distribution<double> spread(0, std::min(width, height) / (4 * sqrt(double(clusters))));
+        std::uniform_int_distribution<size_t> pick(0, clusters - 1);
+        for (size_t i = 0; i < n; i++) {
+            size_t k = pick(gen);
+            // точка за пределами поля берётся заново: прижатые к краю легли бы на его прямые
+            double x, y;
+            do {
+                x = cx[k] + spread(gen);
+                y = cy[k] + spread(gen);
+            } while (x < 0 || x > width || y < 0 || y > height);
+            points.push_back(x, y);
+        }
+        break;
+    }
+
+    case Distribution::grid: {
+        size_t cols = std::max<size_t>(1, size_t(ceil(sqrt(double(n) * width / height))));
+        size_t rows = (n + cols - 1) / cols;
+        double step = std::min(width / cols, rows > 0 ? height / rows : height);
+        for (size_t i = 0; i < n; i++) {
+            points.push_back(double(i % cols) * step, double(i / cols) * step);
+        }
+        break;
+    }
+
+    case Distribution::collinear: {
+        size_t lines = std::max<size_t>(2, size_t(sqrt(double(n)) / 4));
+        std::vector<double> level(lines);
+        for (size_t k = 0; k < lines; k++) {
+            level[k] = k % 2 == 0 ? y_coord(gen) : x_coord(gen);
+        }
+        std::uniform_int_distribution<size_t> pick(0, lines - 1);
+        std::uniform_int_distribution<int> noise(0, 9);
+        for (size_t i = 0; i < n; i++) {
+            double x = x_coord(gen);
+            double y = y_coord(gen);
+            if (noise(gen) != 0) {
+                size_t k = pick(gen);
+                // чётные прямые горизонтальные, нечётные вертикальные
+                (k % 2 == 0 ? y : x) = level[k];
+            }
+            points.push_back(x, y);
+        }
+        break;
+    }
+
+    case Distribution::circle: {
+        const double pi = acos(-1.0);
+        double r = std::min(width, height) / 2;
+        for (size_t i = 0; i < n; i++) {
+            double angle = 2 * pi * double(i) / double(n);
+            points.push_back(width / 2 + r * cos(angle), height / 2 + r * sin(angle));
+        }
+        break;
+    }
+    }
+    return points;
+}
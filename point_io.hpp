@@ -0,0 +1,212 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <fstream>
+#include <charconv>
+#include <stdexcept>
+#include <cstddef>
+#include <cstring>
+#include "mesh.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define POINT_IO_MMAP 1
+#endif
+
+
+// Разбор текстового файла точек: "n x1 y1 x2 y2 ..." (любые пробельные разделители).
+// Данные подаются кусками, число на границе куска переносится в следующий кусок,
+// поэтому весь файл в памяти держать не нужно. Числа читаются std::from_chars.
+class PointParser {
+public:
+    // разбирает [begin, end); last - данных больше не будет.
+    // Возвращает число символов в конце куска, которые не разобраны (начало незаконченного числа):
+    // их нужно передать заново в начале следующего куска.
+    size_t feed(const char* begin, const char* end, bool last) {
+        const char* p = begin;
+        while (!done()) {
+            while (p != end && is_space(*p)) {
+                p++;
+            }
+            if (p == end) {
+                return 0;
+            }
+            const char* token = p;
+            while (p != end && !is_space(*p)) {
+                p++;
+            }
+            if (p == end && !last) {
+                return size_t(end - token);
+            }
+            parse(token, p);
+        }
+        return 0;
+    }
+
+    // все точки прочитаны? (до этого заголовок n должен быть разобран)
+    bool done() const {
+        return expected_ >= 0 && points_.size() == size_t(expected_);
+    }
+
+    PointSet take() {
+        if (expected_ < 0) {
+            throw std::runtime_error("points file: no point count");
+        }
+        if (!done()) {
+            throw std::runtime_error("points file: expected " + std::to_string(expected_) +
+                                     " points, got " + std::to_string(points_.size()));
+        }
+        return std::move(points_);
+    }
+
+private:
+    static bool is_space(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    void parse(const char* begin, const char* end) {
+        if (expected_ < 0) {
+            long long n = 0;
+            auto r = std::from_chars(begin, end, n);
+            if (r.ec != std::errc() || r.ptr != end || n < 0) {
+                throw std::runtime_error("points file: bad point count '" + std::string(begin, end) + "'");
+            }
+            expected_ = n;
+            points_.reserve(size_t(n));
+            return;
+        }
+        double v = 0;
+        auto r = std::from_chars(begin, end, v);
+        if (r.ec != std::errc() || r.ptr != end) {
+            throw std::runtime_error("points file: bad number '" + std::string(begin, end) + "'");
+        }
+        if (!have_x_) {
+            x_ = v;
+            have_x_ = true;
+        }
+        else {
+            points_.push_back(x_, v);
+            have_x_ = false;
+        }
+    }
+
+    PointSet points_;
+    long long expected_ = -1;
+    bool have_x_ = false;
+    double x_ = 0;
+};
+
+
+// чтение из потока кусками по chunk байт
+inline PointSet read_points(std::istream& in, size_t chunk = size_t(1) << 16) {
+    PointParser parser;
+    std::vector<char> buffer(chunk);
+    size_t carry = 0;
+    while (!parser.done()) {
+        if (carry == buffer.size()) {
+            // одно "число" длиннее буфера - расширяем, parse всё равно его отвергнет или прочитает
+            buffer.resize(2 * buffer.size());
+        }
+        in.read(buffer.data() + carry, std::streamsize(buffer.size() - carry));
+        size_t size = carry + size_t(in.gcount());
+        bool last = !in;
+        carry = parser.feed(buffer.data(), buffer.data() + size, last);
+        if (last) {
+            break;
+        }
+        std::memmove(buffer.data(), buffer.data() + size - carry, carry);
+    }
+    return parser.take();
+}
+
+
+// Файл, отображённый в память только для чтения (mmap). Страницы подгружает ОС по мере чтения,
+// копии файла в памяти процесса нет. Там, где mmap нет, data() пуст и mapped() == false.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef POINT_IO_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const char*>(p);
+                size_ = size_t(st.st_size);
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+#else
+        (void)path;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef POINT_IO_MMAP
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool mapped() const {
+        return data_ != nullptr;
+    }
+
+    const char* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+
+// Чтение файла точек: через mmap, если получится, иначе потоком кусками.
+// Ошибки (нет файла, не число, точек меньше заявленного) - std::runtime_error.
+inline PointSet read_points(const std::string& path) {
+    {
+        MappedFile file(path);
+        if (file.mapped()) {
+            PointParser parser;
+            parser.feed(file.data(), file.data() + file.size(), true);
+            return parser.take();
+        }
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    return read_points(in);
+}
+
+
+// запись в текстовом формате "n" и по строке "x y" на точку; числа - кратчайшая точная запись (std::to_chars)
+inline void write_points(std::ostream& out, const PointSet& points) {
+    out << points.size() << "\n";
+    char line[64];
+    for (size_t i = 0; i < points.size(); i++) {
+        char* end = std::to_chars(line, line + sizeof(line), points.xs[i]).ptr;
+        *end++ = ' ';
+        end = std::to_chars(end, line + sizeof(line), points.ys[i]).ptr;
+        *end++ = '\n';
+        out.write(line, end - line);
+    }
+}
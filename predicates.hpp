@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+
+// правило, по которому кандидат считается пересекающим принятое ребро
+enum class CrossingRule {
+    legacy,   // Edge::crosses: деление и сравнение точки пересечения с концами, как было раньше
+    robust    // точные предикаты: касание и наложение на одной прямой - пересечение, общий конец - нет
+};
+
+
+// Устойчивые предикаты. Ориентация сначала считается в double с оценкой погрешности,
+// и только если знак не гарантирован - точно, суммой разложений (Shewchuk, "Adaptive Precision
+// Floating-Point Arithmetic and Fast Robust Geometric Predicates"). Ответ не зависит от сборки
+// (FMA-сжатие оценку погрешности только уменьшает), -ffast-math использовать нельзя.
+namespace predicates {
+
+inline void two_sum(double a, double b, double& x, double& y) {
+    x = a + b;
+    double bv = x - a;
+    double av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+inline void two_product(double a, double b, double& x, double& y) {
+    x = a * b;
+    y = std::fma(a, b, -x);
+}
+
+// h = e + b; e - неперекрывающееся разложение по возрастанию модулей, нули выбрасываются
+inline int grow_expansion(int elen, const double* e, double b, double* h) {
+    double q = b;
+    int hlen = 0;
+    for (int i = 0; i < elen; i++) {
+        double sum, err;
+        two_sum(q, e[i], sum, err);
+        q = sum;
+        if (err != 0) {
+            h[hlen++] = err;
+        }
+    }
+    if (q != 0 || hlen == 0) {
+        h[hlen++] = q;
+    }
+    return hlen;
+}
+
+inline int sign(double v) {
+    return (v > 0) - (v < 0);
+}
+
+// точный знак ax*by - ay*bx + bx*cy - by*cx + cx*ay - cy*ax
+inline int orient2d_exact(double ax, double ay, double bx, double by, double cx, double cy) {
+    double terms[12];
+    two_product(ax, by, terms[0], terms[1]);
+    two_product(-ay, bx, terms[2], terms[3]);
+    two_product(bx, cy, terms[4], terms[5]);
+    two_product(-by, cx, terms[6], terms[7]);
+    two_product(cx, ay, terms[8], terms[9]);
+    two_product(-cy, ax, terms[10], terms[11]);
+
+    double buffers[2][16];
+    int len = 0;
+    int cur = 0;
+    for (double t : terms) {
+        len = grow_expansion(len, buffers[cur], t, buffers[1 - cur]);
+        cur = 1 - cur;
+    }
+    return sign(buffers[cur][len - 1]);
+}
+
+// +1 - a, b, c против часовой стрелки, -1 - по часовой, 0 - на одной прямой
+inline int orient2d(double ax, double ay, double bx, double by, double cx, double cy) {
+    const double eps = std::ldexp(1.0, -53);
+    const double bound = (3.0 + 16.0 * eps) * eps;
+    double left = (ax - cx) * (by - cy);
+    double right = (ay - cy) * (bx - cx);
+    double det = left - right;
+    if (std::fabs(det) > bound * (std::fabs(left) + std::fabs(right))) {
+        return sign(det);
+    }
+    return orient2d_exact(ax, ay, bx, by, cx, cy);
+}
+
+// h = e + f: слияние по возрастанию модулей и цепочка two_sum; h - не короче elen + flen
+inline int sum_expansions(int elen, const double* e, int flen, const double* f, double* h) {
+    double merged[1024 + 1024];
+    int i = 0, j = 0, m = 0;
+    while (i < elen || j < flen) {
+        bool take_e = j == flen || (i < elen && std::fabs(e[i]) < std::fabs(f[j]));
+        merged[m++] = take_e ? e[i++] : f[j++];
+    }
+    if (m == 0) {
+        h[0] = 0;
+        return 1;
+    }
+    int hlen = 0;
+    double q = merged[0];
+    for (int k = 1; k < m; k++) {
+        double sum, err;
+        two_sum(q, merged[k], sum, err);
+        q = sum;
+        if (err != 0) {
+            h[hlen++] = err;
+        }
+    }
+    if (q != 0 || hlen == 0) {
+        h[hlen++] = q;
+    }
+    return hlen;
+}
+
+// h = e * b; h - не короче 2 * elen
+inline int scale_expansion(int elen, const double* e, double b, double* h) {
+    int hlen = 0;
+    double q, err;
+    two_product(e[0], b, q, err);
+    if (err != 0) {
+        h[hlen++] = err;
+    }
+    for (int i = 1; i < elen; i++) {
+        double hi, lo, sum;
+        two_product(e[i], b, hi, lo);
+        two_sum(q, lo, sum, err);
+        if (err != 0) {
+            h[hlen++] = err;
+        }
+        q = hi + sum;
+        err = sum - (q - hi);
+        if (err != 0) {
+            h[hlen++] = err;
+        }
+    }
+    if (q != 0 || hlen == 0) {
+        h[hlen++] = q;
+    }
+    return hlen;
+}
+
+// h = e * f; elen <= 32, flen <= 16 (h - не короче 2 * elen * flen)
+inline int multiply_expansions(int elen, const double* e, int flen, const double* f, double* h) {
+    double scaled[64];
+    double sums[2][1024];
+    int len = 1, cur = 0;
+    sums[0][0] = 0;
+    for (int j = 0; j < flen; j++) {
+        int slen = scale_expansion(elen, e, f[j], scaled);
+        len = sum_expansions(len, sums[cur], slen, scaled, sums[1 - cur]);
+        cur = 1 - cur;
+    }
+    std::copy(sums[cur], sums[cur] + len, h);
+    return len;
+}
+
+// точный знак определителя incircle (без сдвига координат: разности - тоже разложения)
+inline int incircle_exact(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+    struct Expansion {
+        int len = 0;
+        double x[16];
+    };
+    auto diff = [](double a, double b) {
+        Expansion d;
+        double x, y;
+        two_sum(a, -b, x, y);
+        d.x[d.len] = y;
+        d.len += y != 0;
+        d.x[d.len++] = x;
+        return d;
+    };
+    auto lift = [](const Expansion& x, const Expansion& y) {
+        double xx[8], yy[8];
+        Expansion l;
+        int xlen = multiply_expansions(x.len, x.x, x.len, x.x, xx);
+        int ylen = multiply_expansions(y.len, y.x, y.len, y.x, yy);
+        l.len = sum_expansions(xlen, xx, ylen, yy, l.x);
+        return l;
+    };
+    auto cross = [](const Expansion& ux, const Expansion& uy, const Expansion& vx, const Expansion& vy) {
+        double left[8], right[8];
+        Expansion c;
+        int llen = multiply_expansions(ux.len, ux.x, vy.len, vy.x, left);
+        int rlen = multiply_expansions(uy.len, uy.x, vx.len, vx.x, right);
+        for (int k = 0; k < rlen; k++) {
+            right[k] = -right[k];
+        }
+        c.len = sum_expansions(llen, left, rlen, right, c.x);
+        return c;
+    };
+    Expansion adx = diff(ax, dx), ady = diff(ay, dy);
+    Expansion bdx = diff(bx, dx), bdy = diff(by, dy);
+    Expansion cdx = diff(cx, dx), cdy = diff(cy, dy);
+    Expansion lifts[3] = { lift(adx, ady), lift(bdx, bdy), lift(cdx, cdy) };
+    Expansion crosses[3] = { cross(bdx, bdy, cdx, cdy), cross(cdx, cdy, adx, ady), cross(adx, ady, bdx, bdy) };
+
+    double terms[3][512];
+    int lens[3];
+    for (int k = 0; k < 3; k++) {
+        lens[k] = multiply_expansions(lifts[k].len, lifts[k].x, crosses[k].len, crosses[k].x, terms[k]);
+    }
+    double pair[1024], det[1536];
+    int plen = sum_expansions(lens[0], terms[0], lens[1], terms[1], pair);
+    int dlen = sum_expansions(plen, pair, lens[2], terms[2], det);
+    return sign(det[dlen - 1]);
+}
+
+// +1 - d строго внутри окружности через a, b, c (a, b, c против часовой стрелки), -1 - снаружи, 0 - на ней
+inline int incircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+    const double eps = std::ldexp(1.0, -53);
+    const double bound = (10.0 + 96.0 * eps) * eps;
+    double adx = ax - dx, ady = ay - dy;
+    double bdx = bx - dx, bdy = by - dy;
+    double cdx = cx - dx, cdy = cy - dy;
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+    double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift
+                     + (std::fabs(cdxady) + std::fabs(adxcdy)) * blift
+                     + (std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+    if (std::fabs(det) > bound * permanent) {
+        return sign(det);
+    }
+    return incircle_exact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+// Конфликтуют ли отрезки ab и cd в триангуляции: пересечение внутри, касание концом внутренней точки
+// или наложение на одной прямой. Единственная общая точка в общем конце конфликтом не считается.
+inline bool segments_conflict(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+    int o1 = orient2d(cx, cy, dx, dy, ax, ay);
+    int o2 = orient2d(cx, cy, dx, dy, bx, by);
+    int o3 = orient2d(ax, ay, bx, by, cx, cy);
+    int o4 = orient2d(ax, ay, bx, by, dx, dy);
+
+    if (o1 == 0 && o2 == 0 && o3 == 0 && o4 == 0) {
+        // на одной прямой: сравниваем проекции на ось, вдоль которой отрезки длиннее
+        bool by_x = std::max(std::fabs(ax - bx), std::fabs(cx - dx)) >= std::max(std::fabs(ay - by), std::fabs(cy - dy));
+        double p0 = by_x ? ax : ay, p1 = by_x ? bx : by;
+        double q0 = by_x ? cx : cy, q1 = by_x ? dx : dy;
+        double lo = std::max(std::min(p0, p1), std::min(q0, q1));
+        double hi = std::min(std::max(p0, p1), std::max(q0, q1));
+        return lo < hi;
+    }
+
+    bool shared = (ax == cx && ay == cy) || (ax == dx && ay == dy) || (bx == cx && by == cy) || (bx == dx && by == dy);
+    if (shared) {
+        // не на одной прямой - значит, общий конец и есть единственная общая точка
+        return false;
+    }
+    if (o1 * o2 > 0 || o3 * o4 > 0) {
+        return false;
+    }
+    return true;
+}
+
+}
+
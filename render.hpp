@@ -0,0 +1,179 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include "mesh.hpp"
+#include "frame_overlay.hpp"
+#include "worker_pool.hpp"
+#include "instrumentation.hpp"
+
+
+//как показывать шаги готовой триангуляции
+struct RenderOptions {
+    bool show = true;            //окно OpenCV (нужен дисплей)
+    int delay_ms = 1000;         //пауза между кадрами в окне; 0 - без паузы
+    std::string frames_dir;      //если не пусто - каждый кадр сохраняется сюда как frame_000000.png
+    bool hold = true;            //после последнего кадра ждать нажатия клавиши
+    std::string video;           //render_offline: все кадры в один видеофайл (*.avi - MJPG, иначе mp4v)
+    double fps = 25;             //кадров в секунду в видео
+    unsigned threads = 0;        //потоков для render_offline (0 - по числу ядер)
+};
+
+//концы ребра k в координатах окна
+inline cv::Point EdgeStart(const Mesh& mesh, uint32_t k) {
+    uint32_t a = mesh.edges.a[k];
+    return cv::Point(static_cast<int>(mesh.points.xs[a]), static_cast<int>(mesh.points.ys[a]));
+}
+
+inline cv::Point EdgeEnd(const Mesh& mesh, uint32_t k) {
+    uint32_t b = mesh.edges.b[k];
+    return cv::Point(static_cast<int>(mesh.points.xs[b]), static_cast<int>(mesh.points.ys[b]));
+}
+
+//функция проверяющая видимость окна
+inline bool isWindowClosed(const std::string& windowName) {
+    return cv::getWindowProperty(windowName, cv::WND_PROP_VISIBLE) < 1;
+}
+
+inline void DrawPoints(const PointSet& points, cv::Mat& image) {
+    for (int i = 0; i < points.size(); i++) {
+        cv::Point centre(static_cast<int>(points.xs[i]), static_cast<int>(points.ys[i]));
+        cv::circle(image, centre, 2, cv::Scalar(255, 255, 255), 4);
+    }
+}
+
+
+//Показ шагов уже посчитанной триангуляции: хорошие рёбра копятся жёлтым в постоянном слое,
+//отклонённое ребро подсвечивается красным поверх него и снимается перед следующим кадром.
+//Стоимость кадра не зависит от числа уже принятых рёбер. Кадры идут в окно и/или в файлы.
+//Возвращает false, если окно закрыли (Esc или крестик) до конца.
+inline bool render_steps(const Mesh& mesh, const RenderOptions& options) {
+    STATS_STAGE("render");
+    const PointSet& points = mesh.points;
+    const EdgeList& result = mesh.edges;
+    const std::string window = "Display window";
+
+    //точки и принятые рёбра
+    OverlayCanvas canvas(800, 1450, cv::Scalar(0, 0, 0));
+    DrawPoints(points, canvas.image());
+
+    if (options.show) {
+        //Создаём окно для работы
+        cv::namedWindow(window, cv::WINDOW_AUTOSIZE);
+    }
+
+    size_t frame = 0;
+    //кадр: в файл и/или в окно; false - окно закрыли
+    auto emit = [&](const cv::Mat& image) {
+        if (!options.frames_dir.empty()) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%06zu.png", frame);
+            cv::imwrite(options.frames_dir + name, image);
+        }
+        frame++;
+        if (!options.show) {
+            return true;
+        }
+        cv::imshow(window, image);
+        int k = cv::waitKey(options.delay_ms > 0 ? options.delay_ms : 1);
+        return !(k == 27 || isWindowClosed(window));
+    };
+
+    //флаг показывающий заврешилась ли программа штатно и нужно ли выводить итоговый результат
+    bool finished = true;
+
+    for (uint32_t i = 0; i < result.size() && finished; i++) {
+        if (result.verification[i] == true) {
+            canvas.commit_line(EdgeStart(mesh, i), EdgeEnd(mesh, i), cv::Scalar(0, 255, 255), 4);
+            finished = emit(canvas.image());
+        }
+        else {
+            finished = emit(canvas.highlight(EdgeStart(mesh, i), EdgeEnd(mesh, i), cv::Scalar(0, 0, 255), 4));
+        }
+    }
+    canvas.clear_highlight();
+
+    if (options.show) {
+        if (finished && options.hold) {
+            cv::imshow(window, canvas.image());
+            cv::waitKey(0);
+        }
+        cv::destroyAllWindows();
+    }
+    return finished;
+}
+
+
+//Запись шагов без окна и без пауз: PNG в frames_dir и/или видео в video, кадры те же, что у render_steps.
+//Журнал решений - mesh.edges по порядку; кадр k - точки и принятые рёбра шагов до k плюс сам шаг k.
+//Кадры считаются пачками по несколько на поток. Контрольная точка - слой на начало пачки: каждый кадр
+//восстанавливается из неё дорисовкой принятых рёбер пачки до своего шага, поэтому кадры пачки независимы
+//и рисуются (и кодируются в PNG) параллельно. Видео пишется по порядку после пачки: VideoWriter однопоточный.
+//Ошибки записи - исключение std::runtime_error.
+inline void render_offline(const Mesh& mesh, const RenderOptions& options) {
+    STATS_STAGE("render_offline");
+    const EdgeList& result = mesh.edges;
+    const cv::Scalar good(0, 255, 255), bad(0, 0, 255);
+
+    cv::Mat checkpoint(800, 1450, CV_8UC3, cv::Scalar(0, 0, 0));
+    DrawPoints(mesh.points, checkpoint);
+
+    cv::VideoWriter video;
+    if (!options.video.empty()) {
+        const std::string& name = options.video;
+        bool avi = name.size() > 4 && name.compare(name.size() - 4, 4, ".avi") == 0;
+        int fourcc = avi ? cv::VideoWriter::fourcc('M', 'J', 'P', 'G') : cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+        if (!video.open(name, fourcc, options.fps, checkpoint.size())) {
+            throw std::runtime_error("cannot open " + name);
+        }
+    }
+
+    WorkerPool pool(options.threads);
+    const size_t batch = 4 * size_t(pool.size());
+    std::vector<cv::Mat> frames(batch);
+    std::atomic<bool> failed(false);
+    for (size_t first = 0; first < result.size(); first += batch) {
+        size_t count = std::min(batch, result.size() - first);
+        pool.parallel_for(count, [&](size_t k) {
+            size_t step = first + k;
+            cv::Mat& frame = frames[k];
+            checkpoint.copyTo(frame);
+            for (size_t s = first; s <= step; s++) {
+                if (result.verification[s]) {
+                    cv::line(frame, EdgeStart(mesh, s), EdgeEnd(mesh, s), good, 4);
+                }
+            }
+            if (!result.verification[step]) {
+                cv::line(frame, EdgeStart(mesh, step), EdgeEnd(mesh, step), bad, 4);
+            }
+            if (!options.frames_dir.empty()) {
+                char name[32];
+                std::snprintf(name, sizeof(name), "/frame_%06zu.png", step);
+                if (!cv::imwrite(options.frames_dir + name, frame)) {
+                    failed = true;
+                }
+            }
+        }, 1);
+        if (failed) {
+            throw std::runtime_error("cannot write frames to " + options.frames_dir);
+        }
+        for (size_t k = 0; k < count && video.isOpened(); k++) {
+            video.write(frames[k]);
+        }
+        //контрольная точка следующей пачки
+        for (size_t s = first; s < first + count; s++) {
+            if (result.verification[s]) {
+                cv::line(checkpoint, EdgeStart(mesh, s), EdgeEnd(mesh, s), good, 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "crosses_simd.hpp"
+#include "instrumentation.hpp"
+
+
+// равномерная сетка поверх ограничивающего прямоугольника
+struct UniformGrid {
+    double min_x = 0;
+    double min_y = 0;
+    double max_x = 0;
+    double max_y = 0;
+    double cell = 1;
+    int cols = 1;
+    int rows = 1;
+
+    UniformGrid() = default;
+
+    // count - сколько объектов ожидается, per_cell - сколько их в среднем приходится на ячейку
+    UniformGrid(double x0, double y0, double x1, double y1, size_t count, double per_cell) {
+        min_x = x0;
+        min_y = y0;
+        max_x = x1;
+        max_y = y1;
+        double w = max_x - min_x;
+        double h = max_y - min_y;
+        double side = std::max(w, h);
+        if (!(side > 0) || count == 0) {
+            return;
+        }
+        // для вытянутых наборов считаем площадь по стороне, иначе ячеек будет слишком много
+        double area = std::max(w * h, side * side / count);
+        cell = sqrt(area * per_cell / count);
+        cols = int(std::min(w / cell, 4.0 * count)) + 1;
+        rows = int(std::min(h / cell, 4.0 * count)) + 1;
+    }
+
+    UniformGrid(const std::vector<double>& xs, const std::vector<double>& ys, double per_cell) {
+        if (xs.empty()) {
+            return;
+        }
+        auto x = std::minmax_element(xs.begin(), xs.end());
+        auto y = std::minmax_element(ys.begin(), ys.end());
+        *this = UniformGrid(*x.first, *y.first, *x.second, *y.second, xs.size(), per_cell);
+    }
+
+    UniformGrid(const PointSet& points, double per_cell)
+        : UniformGrid(points.xs, points.ys, per_cell) {}
+
+    double diagonal() const {
+        return sqrt(pow(max_x - min_x, 2) + pow(max_y - min_y, 2));
+    }
+
+    // координаты за пределами прямоугольника прижимаются к крайним ячейкам
+    int col(double x) const {
+        double t = floor((x - min_x) / cell);
+        if (!(t > 0)) {
+            return 0;
+        }
+        return t >= cols ? cols - 1 : int(t);
+    }
+
+    int row(double y) const {
+        double t = floor((y - min_y) / cell);
+        if (!(t > 0)) {
+            return 0;
+        }
+        return t >= rows ? rows - 1 : int(t);
+    }
+
+    int size() const {
+        return cols * rows;
+    }
+
+    int index(int c, int r) const {
+        return r * cols + c;
+    }
+
+    // обходит все ячейки, которые может задеть отрезок ab (с небольшим запасом на погрешность)
+    template <class F>
+    void for_each_cell(const Point& a, const Point& b, F&& f) const {
+        double eps = cell * 1e-6;
+        double x0 = a.x_, y0 = a.y_, x1 = b.x_, y1 = b.y_;
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        double dx = x1 - x0;
+        int c0 = col(x0 - eps);
+        int c1 = col(x1 + eps);
+        for (int c = c0; c <= c1; c++) {
+            double ya = y0, yb = y1;
+            if (dx > 0) {
+                double lo = c == c0 ? x0 : std::min(std::max(min_x + c * cell, x0), x1);
+                double hi = c == c1 ? x1 : std::min(std::max(min_x + (c + 1) * cell, x0), x1);
+                ya = y0 + (lo - x0) / dx * (y1 - y0);
+                yb = y0 + (hi - x0) / dx * (y1 - y0);
+            }
+            int r0 = row(std::min(ya, yb) - eps);
+            int r1 = row(std::max(ya, yb) + eps);
+            for (int r = r0; r <= r1; r++) {
+                f(index(c, r));
+            }
+        }
+    }
+};
+
+
+// Индекс отрезков на равномерной сетке: отрезок записывается во все ячейки, через которые проходит.
+// Запрос обходит ячейки вдоль отрезка-запроса, так что проверяются только отрезки поблизости
+// (для равномерно распределённых данных - O(1) кандидатов вместо всех).
+// Отрезки за пределами прямоугольника сетки тоже допустимы, но собираются в крайних ячейках.
+// Каждая ячейка хранит копии концов своих отрезков отдельными массивами, чтобы проверять её
+// пакетом (crosses_simd), даже если в ячейке скопилось много длинных рёбер.
+class SegmentIndex {
+public:
+    SegmentIndex() = default;
+
+    // rule - по какому правилу считать пересечения (см. predicates.hpp)
+    explicit SegmentIndex(const UniformGrid& grid, CrossingRule rule = CrossingRule::legacy)
+        : grid_(grid), cells_(grid.size()), rule_(rule) {}
+
+    // пакетная загрузка: сетка подбирается по концам рёбер
+    explicit SegmentIndex(const std::vector<Edge>& edges, CrossingRule rule = CrossingRule::legacy)
+        : rule_(rule) {
+        PointSet ends;
+        ends.reserve(2 * edges.size());
+        for (const Edge& e : edges) {
+            ends.push_back(e.A_.x_, e.A_.y_);
+            ends.push_back(e.B_.x_, e.B_.y_);
+        }
+        grid_ = UniformGrid(ends, 4.0);
+        cells_.assign(grid_.size(), {});
+        reserve(edges.size());
+        for (const Edge& e : edges) {
+            insert(e.A_, e.B_);
+        }
+    }
+
+    // пустой индекс на новой сетке; память ячеек остаётся от прошлого использования
+    void reset(const UniformGrid& grid, CrossingRule rule) {
+        grid_ = grid;
+        rule_ = rule;
+        cells_.resize(grid.size());
+        for (Cell& cell : cells_) {
+            cell.clear();
+        }
+        ends_.clear();
+        stamp_.clear();
+        epoch_ = 0;
+    }
+
+    const UniformGrid& grid() const {
+        return grid_;
+    }
+
+    CrossingRule rule() const {
+        return rule_;
+    }
+
+    // сколько номеров выдано (вместе с удалёнными отрезками)
+    size_t size() const {
+        return stamp_.size();
+    }
+
+    void reserve(size_t n) {
+        ends_.reserve(2 * n);
+        stamp_.reserve(n);
+    }
+
+    Edge segment(uint32_t id) const {
+        return Edge(ends_[2 * id], ends_[2 * id + 1]);
+    }
+
+    uint32_t insert(const Point& a, const Point& b) {
+        uint32_t id = uint32_t(stamp_.size());
+        ends_.push_back(a);
+        ends_.push_back(b);
+        stamp_.push_back(0);
+        grid_.for_each_cell(a, b, [&](int c) { cells_[c].push_back(id, a, b); });
+        return id;
+    }
+
+    uint32_t insert(const Edge& e) {
+        return insert(e.A_, e.B_);
+    }
+
+    // убрать отрезок id из ячеек; номер больше не выдаётся, size() по-прежнему считает выданные номера
+    void remove(uint32_t id) {
+        grid_.for_each_cell(ends_[2 * id], ends_[2 * id + 1], [&](int c) { cells_[c].erase(id); });
+    }
+
+    // вызывает f(id) для каждого отрезка, делящего с ab хотя бы одну ячейку; f возвращает true, чтобы остановиться
+    template <class F>
+    bool visit(const Point& a, const Point& b, F&& f) {
+        next_epoch();
+        bool stop = false;
+        grid_.for_each_cell(a, b, [&](int c) {
+            const Cell& cell = cells_[c];
+            for (size_t k = 0; k < cell.ids.size() && !stop; k++) {
+                uint32_t id = cell.ids[k];
+                if (stamp_[id] == epoch_) {
+                    continue;
+                }
+                stamp_[id] = epoch_;
+                stop = f(id);
+            }
+        });
+        return stop;
+    }
+
+    // пересекает ли отрезок ab хотя бы один отрезок индекса (по правилу индекса)
+    // проверяются только отрезки с номерами из [first, last): first - вставленные позже, last - вставленные раньше;
+    // в ячейке номера идут по возрастанию
+    bool crosses_any(const Point& a, const Point& b, uint32_t first = 0,
+                     uint32_t last = std::numeric_limits<uint32_t>::max()) const {
+        STATS_COUNT(crosses_calls, 1);
+        bool found = false;
+        grid_.for_each_cell(a, b, [&](int c) {
+            const Cell& cell = cells_[c];
+            if (found || cell.ids.empty() || cell.ids.back() < first || cell.ids.front() >= last) {
+                return;
+            }
+            size_t k = first == 0 ? 0 : std::lower_bound(cell.ids.begin(), cell.ids.end(), first) - cell.ids.begin();
+            size_t end = cell.ids.back() < last ? cell.ids.size() :
+                std::lower_bound(cell.ids.begin() + k, cell.ids.end(), last) - cell.ids.begin();
+            size_t count = end - k;
+            size_t hit = count == 0 ? 0 : crosses_simd::first_crossing(a, b, cell.cx.data() + k, cell.cy.data() + k,
+                cell.dx.data() + k, cell.dy.data() + k, count, rule_);
+            found = hit < count;
+            STATS_COUNT(segment_tests, found ? hit + 1 : count);
+        });
+        STATS_COUNT(early_exits, found);
+        return found;
+    }
+
+    bool crosses_any(const Edge& e) const {
+        return crosses_any(e.A_, e.B_);
+    }
+
+    // номера всех отрезков индекса, которые пересекает e
+    std::vector<uint32_t> crossing(const Edge& e) {
+        STATS_COUNT(crosses_calls, 1);
+        std::vector<uint32_t> ids;
+        next_epoch();
+        grid_.for_each_cell(e.A_, e.B_, [&](int c) {
+            const Cell& cell = cells_[c];
+            size_t count = cell.ids.size();
+            size_t k = 0;
+            while (k < count) {
+                size_t hit = crosses_simd::first_crossing(e.A_, e.B_, cell.cx.data() + k, cell.cy.data() + k,
+                    cell.dx.data() + k, cell.dy.data() + k, count - k, rule_);
+                STATS_COUNT(segment_tests, k + hit < count ? hit + 1 : hit);
+                k += hit;
+                if (k == count) {
+                    break;
+                }
+                uint32_t id = cell.ids[k++];
+                if (stamp_[id] != epoch_) {
+                    stamp_[id] = epoch_;
+                    ids.push_back(id);
+                }
+            }
+        });
+        return ids;
+    }
+
+private:
+    // отрезки одной ячейки: номера и концы отдельными массивами
+    struct Cell {
+        std::vector<uint32_t> ids;
+        std::vector<double> cx;
+        std::vector<double> cy;
+        std::vector<double> dx;
+        std::vector<double> dy;
+
+        void push_back(uint32_t id, const Point& a, const Point& b) {
+            ids.push_back(id);
+            cx.push_back(a.x_);
+            cy.push_back(a.y_);
+            dx.push_back(b.x_);
+            dy.push_back(b.y_);
+        }
+
+        void clear() {
+            ids.clear();
+            cx.clear();
+            cy.clear();
+            dx.clear();
+            dy.clear();
+        }
+
+        void erase(uint32_t id) {
+            auto it = std::lower_bound(ids.begin(), ids.end(), id);
+            if (it == ids.end() || *it != id) {
+                return;
+            }
+            size_t k = it - ids.begin();
+            ids.erase(it);
+            cx.erase(cx.begin() + k);
+            cy.erase(cy.begin() + k);
+            dx.erase(dx.begin() + k);
+            dy.erase(dy.begin() + k);
+        }
+    };
+
+    void next_epoch() {
+        if (++epoch_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    UniformGrid grid_;
+    std::vector<Cell> cells_;
+    std::vector<Point> ends_;
+    std::vector<uint32_t> stamp_;
+    uint32_t epoch_ = 0;
+    CrossingRule rule_ = CrossingRule::legacy;
+};
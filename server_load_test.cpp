@@ -0,0 +1,276 @@
+// Нагрузочный клиент для triangulation_server: держит до C запросов в полёте и меряет
+// пропускную способность (запросов в секунду) и задержку каждого запроса (от отправки до ответа).
+// Запуск:
+//   server_load_test --socket PATH [ключи]         - к уже запущенному серверу
+//   server_load_test --exec "COMMAND" [ключи]       - запустить сервер самому и говорить с ним через stdin/stdout
+// Ключи: --jobs N (2000), --concurrency C (32), --points P (200), --dist NAME (uniform), --sets K (16),
+//        --seed S, --robust, --verify (сверять ответы с triangulate_fast_mesh, без --robust - с triangulate_mesh).
+// Итог - одна строка key=value (удобно разбирать скриптом).
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <csignal>
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "point_generators.hpp"
+#include "job_protocol.hpp"
+
+#ifndef JOB_PROTOCOL_POSIX
+int main() {
+    std::cerr << "server_load_test needs a POSIX system\n";
+    return 1;
+}
+#else
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+
+struct LoadOptions {
+    std::string socket_path;
+    std::string command;
+    size_t jobs = 2000;
+    size_t concurrency = 32;
+    size_t points = 200;
+    size_t sets = 16;
+    Distribution distribution = Distribution::uniform;
+    unsigned seed = 1;
+    CrossingRule rule = CrossingRule::legacy;
+    bool verify = false;
+};
+
+static bool parse_options(int argc, char** argv, LoadOptions& options) {
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = k + 1 < argc;
+        if (arg == "--socket" && has_value) {
+            options.socket_path = argv[++k];
+        }
+        else if (arg == "--exec" && has_value) {
+            options.command = argv[++k];
+        }
+        else if (arg == "--jobs" && has_value) {
+            options.jobs = size_t(std::atof(argv[++k]));
+        }
+        else if (arg == "--concurrency" && has_value) {
+            options.concurrency = std::max<size_t>(1, size_t(std::atol(argv[++k])));
+        }
+        else if (arg == "--points" && has_value) {
+            options.points = size_t(std::atol(argv[++k]));
+        }
+        else if (arg == "--sets" && has_value) {
+            options.sets = std::max<size_t>(1, size_t(std::atol(argv[++k])));
+        }
+        else if (arg == "--dist" && has_value) {
+            if (!parse_distribution(argv[++k], options.distribution)) {
+                return false;
+            }
+        }
+        else if (arg == "--seed" && has_value) {
+            options.seed = unsigned(std::atol(argv[++k]));
+        }
+        else if (arg == "--robust") {
+            options.rule = CrossingRule::robust;
+        }
+        else if (arg == "--verify") {
+            options.verify = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return options.socket_path.empty() != options.command.empty();
+}
+
+static int connect_unix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::perror(path.c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// запустить command через /bin/sh с трубами на stdin/stdout; false - не вышло
+static bool spawn(const std::string& command, int& to_server, int& from_server, pid_t& child) {
+    int up[2], down[2];
+    if (pipe(up) < 0 || pipe(down) < 0) {
+        return false;
+    }
+    child = fork();
+    if (child < 0) {
+        return false;
+    }
+    if (child == 0) {
+        dup2(up[0], 0);
+        dup2(down[1], 1);
+        close(up[0]);
+        close(up[1]);
+        close(down[0]);
+        close(down[1]);
+        execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(up[0]);
+    close(down[1]);
+    to_server = up[1];
+    from_server = down[0];
+    return true;
+}
+
+int main(int argc, char** argv) {
+    LoadOptions options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "usage: server_load_test (--socket PATH | --exec COMMAND) [--jobs N] [--concurrency C]\n"
+            "                        [--points P] [--dist NAME] [--sets K] [--seed S] [--robust] [--verify]\n";
+        return 2;
+    }
+
+    // если сервер упал, пусть запись вернёт ошибку, а не убьёт клиента
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int out = -1, in = -1;
+    pid_t child = -1;
+    if (!options.socket_path.empty()) {
+        out = in = connect_unix(options.socket_path);
+        if (out < 0) {
+            return 1;
+        }
+    }
+    else if (!spawn(options.command, out, in, child)) {
+        std::perror("spawn");
+        return 1;
+    }
+
+    // несколько наборов точек по кругу: генерация не должна попадать в замер
+    std::vector<PointSet> sets;
+    std::vector<std::vector<char>> requests(options.sets);
+    std::vector<std::vector<uint32_t>> expected(options.sets);
+    for (size_t k = 0; k < options.sets; k++) {
+        sets.push_back(generate_points(options.distribution, options.points, options.seed + unsigned(k)));
+        if (options.verify) {
+            // то же разделение, что в сервере: без --robust ответ совпадает с triangulate_mesh
+            EdgeList edges = options.rule == CrossingRule::robust ? triangulate_fast_mesh(sets[k], options.rule)
+                                                                  : triangulate_mesh(sets[k], 0, options.rule);
+            for (size_t e = 0; e < edges.size(); e++) {
+                if (edges.verification[e]) {
+                    expected[k].push_back(edges.a[e]);
+                    expected[k].push_back(edges.b[e]);
+                }
+            }
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+    std::mutex mutex;
+    std::condition_variable slot;
+    std::unordered_map<uint64_t, clock::time_point> sent;
+    std::vector<double> latency_ms;
+    latency_ms.reserve(options.jobs);
+    size_t errors = 0, mismatches = 0;
+    bool failed = false;
+
+    auto start = clock::now();
+    std::thread receiver([&] {
+        std::vector<char> body;
+        std::vector<uint32_t> pairs;
+        std::string message;
+        for (size_t done = 0; done < options.jobs; done++) {
+            uint32_t status = 0;
+            uint64_t id = 0;
+            try {
+                if (!job_protocol::read_frame(in, body)) {
+                    throw std::runtime_error("server closed the connection");
+                }
+                id = job_protocol::decode_response(body, status, pairs, message);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "error: " << e.what() << "\n";
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+                slot.notify_all();
+                return;
+            }
+            auto now = clock::now();
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = sent.find(id);
+            if (it == sent.end()) {
+                errors++;
+                continue;
+            }
+            latency_ms.push_back(std::chrono::duration<double, std::milli>(now - it->second).count());
+            sent.erase(it);
+            if (status != job_protocol::kOk) {
+                errors++;
+            }
+            else if (options.verify && pairs != expected[id % options.sets]) {
+                mismatches++;
+            }
+            slot.notify_one();
+        }
+    });
+
+    for (uint64_t id = 0; id < options.jobs; id++) {
+        std::vector<char>& request = requests[id % options.sets];
+        job_protocol::encode_request(id, options.rule, sets[id % options.sets], request);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            slot.wait(lock, [&] { return failed || sent.size() < options.concurrency; });
+            if (failed) {
+                break;
+            }
+            sent[id] = clock::now();
+        }
+        if (!job_protocol::write_frame(out, request)) {
+            std::cerr << "error: cannot send request\n";
+            failed = true;
+            break;
+        }
+    }
+    receiver.join();
+    double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    job_protocol::write_end(out);
+    if (child > 0) {
+        close(out);
+        close(in);
+        waitpid(child, nullptr, 0);
+    }
+    else {
+        close(out);
+    }
+
+    std::sort(latency_ms.begin(), latency_ms.end());
+    auto percentile = [&](double p) {
+        if (latency_ms.empty()) {
+            return 0.0;
+        }
+        return latency_ms[std::min(latency_ms.size() - 1, size_t(p * latency_ms.size()))];
+    };
+    std::cout << "jobs=" << latency_ms.size() << " points=" << options.points << " concurrency=" << options.concurrency
+        << " seconds=" << seconds << " jobs_per_sec=" << latency_ms.size() / seconds
+        << " p50_ms=" << percentile(0.50) << " p90_ms=" << percentile(0.90) << " p99_ms=" << percentile(0.99)
+        << " max_ms=" << (latency_ms.empty() ? 0.0 : latency_ms.back())
+        << " errors=" << errors << " mismatches=" << mismatches << "\n";
+    return failed || errors || mismatches ? 1 : 0;
+}
+
+#endif
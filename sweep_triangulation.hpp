@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include "mesh.hpp"
+#include "predicates.hpp"
+
+
+// Триангуляция заметанием: точки идут по возрастанию x (затем y), каждая новая соединяется
+// с предыдущей и со всеми вершинами оболочки уже пройденных точек, которые из неё видны.
+// Оболочка хранится верхней и нижней цепочками, как в построении оболочки Эндрю: видимые вершины
+// снимаются с концов цепочек, так что после сортировки всё делается за O(n).
+// Самый быстрый из движков, но треугольники у него длинные и узкие: сумма длин рёбер заметно больше,
+// чем у жадной триангуляции и у Делоне. Совпадающие точки берутся один раз (по меньшему номеру).
+// Рёбра (i < j), каждое один раз, без определённого порядка.
+inline EdgeList triangulate_sweep(const PointSet& points) {
+    EdgeList result;
+    const uint32_t n = uint32_t(points.size());
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (points.xs[a] != points.xs[b]) {
+            return points.xs[a] < points.xs[b];
+        }
+        return points.ys[a] != points.ys[b] ? points.ys[a] < points.ys[b] : a < b;
+    });
+    order.erase(std::unique(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return points.xs[a] == points.xs[b] && points.ys[a] == points.ys[b];
+    }), order.end());
+    if (order.size() < 2) {
+        return result;
+    }
+
+    auto turn = [&](uint32_t a, uint32_t b, uint32_t c) {
+        return predicates::orient2d(points.xs[a], points.ys[a], points.xs[b], points.ys[b], points.xs[c], points.ys[c]);
+    };
+    auto add = [&](uint32_t a, uint32_t b) {
+        result.push_back(std::min(a, b), std::max(a, b));
+    };
+
+    result.reserve(3 * order.size());
+    std::vector<uint32_t> upper = { order[0] };
+    std::vector<uint32_t> lower = { order[0] };
+    for (size_t k = 1; k < order.size(); k++) {
+        uint32_t p = order[k];
+        add(upper.back(), p);
+        // сторона видна, если p строго по другую сторону от неё, чем уже пройденные точки;
+        // на одной прямой с ней - не видна: ребро прошло бы через вершину
+        while (upper.size() >= 2 && turn(upper[upper.size() - 2], upper.back(), p) > 0) {
+            upper.pop_back();
+            add(upper.back(), p);
+        }
+        while (lower.size() >= 2 && turn(lower[lower.size() - 2], lower.back(), p) < 0) {
+            lower.pop_back();
+            add(lower.back(), p);
+        }
+        upper.push_back(p);
+        lower.push_back(p);
+    }
+    return result;
+}
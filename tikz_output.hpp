@@ -0,0 +1,183 @@
+#pragma once
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "mesh.hpp"
+#include "instrumentation.hpp"
+
+
+//title - заголовок документа (у продолжений, см. TikzWriter::restart, его нет)
+inline void makePreamble(std::ostream& fout, bool title = true) {
+    fout << R"(\documentclass[a4paper]{article})" << std::endl;
+    fout << R"(\usepackage{pgfplots})" << std::endl;
+    fout << R"(\usepackage{tikz})" << std::endl;
+    fout << R"(\usepackage{tkz-euclide})" << std::endl;
+    fout << R"(\usepackage[english, russian]{babel})" << std::endl;
+    fout << R"(\usepackage[T2A]{fontenc})" << std::endl;
+    fout << R"(\usepackage[utf8]{inputenc})" << std::endl;
+    fout << R"(\usepackage{geometry})" << std::endl;
+    fout << R"(\pgfplotsset{compat = 1.18})" << std::endl;
+    fout << R"(\geometry{top = 20mm})" << std::endl;
+    fout << R"(\geometry{bottom = 25mm})" << std::endl;
+    fout << R"(\geometry{left = 25mm})" << std::endl;
+    fout << R"(\geometry{right = 25mm})" << std::endl;
+    //принятые рёбра копятся готовым боксом \acceptedbox: \addedge добавляет в него одно ребро (рисунок
+    //нулевого размера с началом координат в точке бокса), рисунок шага ставит бокс в начало координат.
+    //Так рёбра разбираются TikZ по разу, а не заново в каждом рисунке
+    fout << R"(\newsavebox{\acceptedbox})" << std::endl;
+    fout << R"(\newcommand{\addedge}[4]{\global\setbox\acceptedbox\hbox{\box\acceptedbox\tikz[overlay]\draw[ultra thick, green](#1, #2)--(#3, #4);}})" << std::endl;
+    fout << R"(\newcommand{\acceptedlayer}{\begin{pgfinterruptboundingbox}\pgftext[left, base]{\usebox{\acceptedbox}}\end{pgfinterruptboundingbox}})" << std::endl;
+    //рисунки шагов: после серии принятых рёбер и с отклонённым ребром
+    fout << R"(\newcommand{\goodstep}{\section{ood edges}\begin{tikzpicture}\pointlayer\acceptedlayer\end{tikzpicture}})" << std::endl;
+    fout << R"(\newcommand{\badstep}[4]{\section{Adding bad edges.}\begin{tikzpicture}\pointlayer\acceptedlayer\draw[ultra thick, red](#1, #2)--(#3, #4);\end{tikzpicture}})" << std::endl;
+    fout << R"(\title{Visualization of the Greedy triangulation algorithm.})" << std::endl;
+    fout << R"(\begin{document})" << std::endl;
+    if (title) {
+        fout << R"(\maketitle)" << std::endl;
+    }
+}
+
+
+//какие шаги рисовать
+struct TikzOptions {
+    size_t every = 1;             //рисовать каждый every-й из выбранных шагов (последний итог - всегда)
+    bool accepted_steps = true;   //рисунок после каждой серии подряд принятых рёбер
+    bool rejected_steps = true;   //рисунок на каждое отклонённое ребро
+};
+
+
+//LaTeX-визуализация по шагам, без повторов: точки один раз записываются в макрос \pointlayer,
+//каждое принятое ребро - один раз через \addedge в бокс \acceptedbox, а рисунок шага - одна строка
+//\goodstep или \badstep, которая ссылается на них. Размер файла - O(точек + рёбер + шагов),
+//а не O(шагов * рёбер); шагов с отклонёнными рёбрами до n^2 / 2, поэтому их строки короткие.
+//Рёбра подаются по порядку: accept/reject, в конце finish.
+//Документ можно в любой момент продолжить в другом потоке (restart) - так вывод режется на файлы,
+//которые компилируются по отдельности (tikz_shards.hpp).
+class TikzWriter {
+public:
+    TikzWriter(std::ostream& fout, const PointSet& points, const TikzOptions& options = TikzOptions())
+        : fout_(&fout), points_(points), options_(options), begin_(fout.tellp()) {
+        if (options_.every == 0) {
+            options_.accepted_steps = options_.rejected_steps = false;
+            options_.every = 1;
+        }
+        makePreamble(*fout_);
+        point_layer();
+
+        *fout_ << R"(\section{Points layout})" << std::endl;
+        *fout_ << R"(\begin{tikzpicture})" << std::endl;
+        for (size_t i = 0; i < points_.size(); i++) {
+            *fout_ << R"(\filldraw[red])" << "(" << points_.xs[i] / 50 << ","
+                << -(points_.ys[i] / 50) << ")" << "circle(4pt);" << std::endl;
+        }
+        *fout_ << R"(\end{tikzpicture})" << std::endl;
+    }
+
+    void accept(uint32_t a, uint32_t b) {
+        add_edge(a, b);
+        accepted_.push_back(a);
+        accepted_.push_back(b);
+        pending_ = true;
+    }
+
+    void reject(uint32_t a, uint32_t b) {
+        flush_accepted();
+        if (!options_.rejected_steps || !take_step()) {
+            return;
+        }
+        *fout_ << R"(\badstep{)" << points_.xs[a] / 50 << "}{" << -(points_.ys[a] / 50) << "}{"
+            << points_.xs[b] / 50 << "}{" << -(points_.ys[b] / 50) << "}" << std::endl;
+        pictures_++;
+    }
+
+    //сколько рисунков шагов записано
+    size_t pictures() const {
+        return pictures_;
+    }
+
+    //закончить текущий документ и продолжить в fout новым, самостоятельным: без заголовка,
+    //с теми же точками и уже принятыми рёбрами; незаконченная серия принятых рёбер переходит в него
+    void restart(std::ostream& fout) {
+        end_document();
+        fout_ = &fout;
+        begin_ = fout.tellp();
+        makePreamble(*fout_, false);
+        point_layer();
+        for (size_t k = 0; k < accepted_.size(); k += 2) {
+            add_edge(accepted_[k], accepted_[k + 1]);
+        }
+    }
+
+    void finish() {
+        flush_accepted();
+        *fout_ << R"(\section{Final result.})" << std::endl;
+        *fout_ << R"(\begin{tikzpicture}\pointlayer\acceptedlayer\end{tikzpicture})" << std::endl;
+        end_document();
+    }
+
+private:
+    //рисунок после серии принятых рёбер (если серия была)
+    void flush_accepted() {
+        if (!pending_) {
+            return;
+        }
+        pending_ = false;
+        if (!options_.accepted_steps || !take_step()) {
+            return;
+        }
+        *fout_ << R"(\goodstep)" << std::endl;
+        pictures_++;
+    }
+
+    bool take_step() {
+        return step_++ % options_.every == 0;
+    }
+
+    void point_layer() {
+        *fout_ << R"(\newcommand{\pointlayer}{)" << std::endl;
+        for (size_t i = 0; i < points_.size(); i++) {
+            *fout_ << R"(\filldraw[black])" << "(" << points_.xs[i] / 50 << ","
+                << -(points_.ys[i] / 50) << ")" << "circle(2pt);" << std::endl;
+        }
+        *fout_ << "}" << std::endl;
+    }
+
+    void add_edge(uint32_t a, uint32_t b) {
+        *fout_ << R"(\addedge{)" << points_.xs[a] / 50 << "}{" << -(points_.ys[a] / 50) << "}{"
+            << points_.xs[b] / 50 << "}{" << -(points_.ys[b] / 50) << "}" << std::endl;
+    }
+
+    void end_document() {
+        *fout_ << R"(\end{document})" << std::endl;
+        STATS_COUNT(tikz_bytes, fout_->tellp() - begin_);
+    }
+
+    std::ostream* fout_;
+    const PointSet& points_;
+    TikzOptions options_;
+    std::streampos begin_;
+    std::vector<uint32_t> accepted_;  //концы принятых рёбер подряд - для restart
+    bool pending_ = false;
+    size_t step_ = 0;
+    size_t pictures_ = 0;
+};
+
+
+//LaTeX-визуализация готовой триангуляции: раскладка точек, серии хороших рёбер,
+//отклонённые рёбра, итог. Окно для этого не нужно.
+inline void write_tikz(const Mesh& mesh, std::ostream& fout, const TikzOptions& options = TikzOptions()) {
+    STATS_STAGE("tikz");
+    TikzWriter writer(fout, mesh.points, options);
+    for (uint32_t i = 0; i < mesh.edges.size(); i++) {
+        if (mesh.edges.verification[i]) {
+            writer.accept(mesh.edges.a[i], mesh.edges.b[i]);
+        }
+        else {
+            writer.reject(mesh.edges.a[i], mesh.edges.b[i]);
+        }
+    }
+    writer.finish();
+}
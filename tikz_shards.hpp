@@ -0,0 +1,186 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include "mesh.hpp"
+#include "tikz_output.hpp"
+#include "worker_pool.hpp"
+#include "instrumentation.hpp"
+
+
+//как собирать PDF из кусков
+struct ShardOptions {
+    size_t pictures = 100;                  //рисунков шагов на файл
+    std::string dir = "tikz_shards";        //куда писать файлы и PDF кусков (там же кэш)
+    std::string pdf = "visualization.pdf";  //итоговый PDF
+    unsigned jobs = 0;                      //одновременных компиляций (0 - по числу ядер)
+    std::string latex = "pdflatex";
+};
+
+//что получилось
+struct ShardReport {
+    size_t shards = 0;
+    size_t compiled = 0;          //скомпилировано сейчас
+    size_t cached = 0;            //PDF куска уже был (такой же текст)
+    size_t failed = 0;
+    bool merged = false;          //итоговый PDF записан
+    double write_seconds = 0;
+    double compile_seconds = 0;
+    double merge_seconds = 0;
+};
+
+
+namespace shard_detail {
+
+//имя файла по содержимому (FNV-1a, 64 бита)
+inline std::string content_name(const std::string& text) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    char name[20];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(h));
+    return name;
+}
+
+//скомпилировать dir/name.tex в dir/name.pdf. Компиляция идёт под временным именем: PDF появляется,
+//только если она прошла, и недоделанный файл не попадёт в кэш
+inline bool compile(const std::string& latex, const std::filesystem::path& dir, const std::string& name) {
+    namespace fs = std::filesystem;
+    std::string job = name + ".part";
+    std::string command = latex + " -interaction=batchmode -halt-on-error -output-directory=\"" + dir.string()
+        + "\" -jobname=" + job + " \"" + (dir / (name + ".tex")).string() + "\"";
+    std::error_code error;
+    if (std::system(command.c_str()) != 0 || !fs::exists(dir / (job + ".pdf"))) {
+        fs::remove(dir / (job + ".pdf"), error);
+        return false;
+    }
+    fs::rename(dir / (job + ".pdf"), dir / (name + ".pdf"), error);
+    return !error;
+}
+
+inline void write_file(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    out << text;
+    if (!out) {
+        throw std::runtime_error("cannot write " + path.string());
+    }
+}
+
+}
+
+
+//LaTeX-визуализация, разрезанная на самостоятельные документы по pictures рисунков шагов:
+//каждый следующий повторяет в начале точки и уже принятые рёбра (TikzWriter::restart).
+//Первый - с заголовком и раскладкой точек, последний - с итогом.
+inline std::vector<std::string> write_tikz_shards(const Mesh& mesh, const TikzOptions& options, size_t pictures) {
+    STATS_STAGE("tikz_shards");
+    std::vector<std::string> shards;
+    //два буфера по очереди: пока writer пишет в один, текст другого забирается в shards
+    std::ostringstream out[2];
+    int current = 0;
+    TikzWriter writer(out[current], mesh.points, options);
+    size_t start = 0;
+    for (uint32_t i = 0; i < mesh.edges.size(); i++) {
+        if (pictures > 0 && writer.pictures() - start >= pictures) {
+            writer.restart(out[1 - current]);
+            shards.push_back(out[current].str());
+            out[current].str("");
+            current = 1 - current;
+            start = writer.pictures();
+        }
+        if (mesh.edges.verification[i]) {
+            writer.accept(mesh.edges.a[i], mesh.edges.b[i]);
+        }
+        else {
+            writer.reject(mesh.edges.a[i], mesh.edges.b[i]);
+        }
+    }
+    writer.finish();
+    shards.push_back(out[current].str());
+    return shards;
+}
+
+//Сборка PDF визуализации: куски (write_tikz_shards) компилируются одновременно, не больше jobs сразу,
+//и склеиваются в один PDF ещё одним документом (pdfpages). Файлы называются по хэшу содержимого,
+//поэтому PDF неизменившегося куска берётся из dir без компиляции - в том числе после другого запуска.
+//Если какой-то кусок не собрался, итоговый PDF не пишется (merged == false), логи LaTeX остаются в dir.
+inline ShardReport build_tikz_pdf(const Mesh& mesh, const TikzOptions& steps, const ShardOptions& options) {
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+    ShardReport report;
+    const fs::path dir(options.dir);
+    fs::create_directories(dir);
+
+    auto start = clock::now();
+    std::vector<std::string> names;
+    std::vector<size_t> todo;
+    {
+        std::vector<std::string> shards = write_tikz_shards(mesh, steps, options.pictures);
+        for (const std::string& text : shards) {
+            names.push_back(shard_detail::content_name(text));
+            bool scheduled = std::find(names.begin(), names.end() - 1, names.back()) != names.end() - 1;
+            if (scheduled || fs::exists(dir / (names.back() + ".pdf"))) {
+                report.cached++;
+                continue;
+            }
+            shard_detail::write_file(dir / (names.back() + ".tex"), text);
+            todo.push_back(names.size() - 1);
+        }
+    }
+    report.shards = names.size();
+    report.write_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    start = clock::now();
+    {
+        STATS_STAGE("latex");
+        //pdflatex - отдельный процесс, потоки только ждут его; кусок на поток за раз
+        std::atomic<size_t> failed(0);
+        WorkerPool pool(options.jobs);
+        pool.parallel_for(todo.size(), [&](size_t k) {
+            if (!shard_detail::compile(options.latex, dir, names[todo[k]])) {
+                failed++;
+            }
+        }, 1);
+        report.failed = failed;
+        report.compiled = todo.size() - report.failed;
+    }
+    report.compile_seconds = std::chrono::duration<double>(clock::now() - start).count();
+    if (report.failed > 0) {
+        return report;
+    }
+
+    start = clock::now();
+    std::ostringstream merge;
+    merge << R"(\documentclass[a4paper]{article})" << std::endl;
+    merge << R"(\usepackage{pdfpages})" << std::endl;
+    merge << R"(\begin{document})" << std::endl;
+    for (const std::string& name : names) {
+        merge << R"(\includepdf[pages=-]{)" << (dir / (name + ".pdf")).generic_string() << "}" << std::endl;
+    }
+    merge << R"(\end{document})" << std::endl;
+    std::string name = "merged_" + shard_detail::content_name(merge.str());
+    if (!fs::exists(dir / (name + ".pdf"))) {
+        shard_detail::write_file(dir / (name + ".tex"), merge.str());
+        if (!shard_detail::compile(options.latex, dir, name)) {
+            report.merge_seconds = std::chrono::duration<double>(clock::now() - start).count();
+            return report;
+        }
+    }
+    std::error_code error;
+    fs::copy_file(dir / (name + ".pdf"), options.pdf, fs::copy_options::overwrite_existing, error);
+    report.merged = !error;
+    report.merge_seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return report;
+}
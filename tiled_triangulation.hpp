@@ -0,0 +1,370 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <unordered_set>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "segment_index.hpp"
+#include "edge_sort.hpp"
+#include "predicates.hpp"
+#include "triangulate.hpp"
+#include "worker_pool.hpp"
+
+
+// параметры разбиения на плитки
+struct TileOptions {
+    size_t tiles = 0;            // число плиток (0 - по 4 на поток, но не меньше ~1000 точек на плитку)
+    double margin = 0;           // ширина полосы перекрытия (0 - 6 средних расстояний между точками)
+    unsigned threads = 0;        // потоков для плиток (0 - по числу ядер)
+    CrossingRule rule = CrossingRule::robust;
+};
+
+// что досталось одной плитке
+struct TileStats {
+    double x0 = 0, y0 = 0, x1 = 0, y1 = 0;   // ядро плитки
+    size_t core_points = 0;                  // точек в ядре
+    size_t points = 0;                       // вместе с полосой перекрытия
+    size_t edges = 0;                        // рёбер с концом в ядре
+    size_t bytes = 0;                        // память под точки плитки, их номера и найденные рёбра
+    double seconds = 0;
+};
+
+// отчёт о плитках и о сшивке
+struct TiledReport {
+    std::vector<TileStats> tiles;
+    size_t candidates = 0;       // рёбер из всех плиток без повторов
+    size_t seam = 0;             // из них проверено заново при сшивке
+    size_t added = 0;            // пар, которых не нашлось ни в одной плитке
+    size_t rounds = 0;           // проходов сшивки
+    double tile_seconds = 0;
+    double stitch_seconds = 0;
+};
+
+
+namespace tiled_detail {
+
+// k-d разбиение: делим по медиане вдоль длинной стороны, пока не наберётся tiles частей.
+// tile_of[i] - плитка точки i, cores - прямоугольники ядер {x0, y0, x1, y1}
+inline void kd_split(const PointSet& points, std::vector<uint32_t>& ids, size_t begin, size_t end, size_t tiles,
+                     double x0, double y0, double x1, double y1,
+                     std::vector<uint32_t>& tile_of, std::vector<TileStats>& cores) {
+    if (tiles <= 1 || end - begin < 2) {
+        TileStats tile;
+        tile.x0 = x0;
+        tile.y0 = y0;
+        tile.x1 = x1;
+        tile.y1 = y1;
+        tile.core_points = end - begin;
+        for (size_t k = begin; k < end; k++) {
+            tile_of[ids[k]] = uint32_t(cores.size());
+        }
+        cores.push_back(tile);
+        return;
+    }
+    bool by_x = x1 - x0 >= y1 - y0;
+    const std::vector<double>& coord = by_x ? points.xs : points.ys;
+    size_t left = tiles / 2;
+    size_t mid = begin + (end - begin) * left / tiles;
+    std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end,
+                     [&](uint32_t a, uint32_t b) { return coord[a] < coord[b]; });
+    double split = coord[ids[mid]];
+    if (by_x) {
+        kd_split(points, ids, begin, mid, left, x0, y0, split, y1, tile_of, cores);
+        kd_split(points, ids, mid, end, tiles - left, split, y0, x1, y1, tile_of, cores);
+    }
+    else {
+        kd_split(points, ids, begin, mid, left, x0, y0, x1, split, tile_of, cores);
+        kd_split(points, ids, mid, end, tiles - left, x0, split, x1, y1, tile_of, cores);
+    }
+}
+
+inline uint64_t key(uint32_t i, uint32_t j) {
+    return (uint64_t(i) << 32) | j;
+}
+
+}
+
+
+// Жадная триангуляция по плиткам для больших наборов точек.
+// Точки делятся k-d разбиением на плитки; каждая плитка вместе с полосой перекрытия шириной margin
+// триангулируется отдельно (triangulate_fast_stream, по потоку на плитку), из неё берутся рёбра с концом в ядре.
+// Сшивка - тот же жадный проход по объединению рёбер плиток в порядке (длина, номера), но заново
+// проверяются только рёбра у швов: ребро, оба конца которого в ядре одной плитки глубже margin, уже
+// проверено в своей плитке и принимается сразу.
+// Затем результат проверяется целиком (характеристика жадного результата: ребро принято тогда и только тогда,
+// когда его не пересекает ни одно более раннее принятое):
+//  - принятое у шва ребро не должно пересекать более позднее принятое внутреннее - иначе то проверяется заново;
+//  - пара, которой нет среди рёбер, должна пересекать более раннее ребро; перебираются только пары короче
+//    радиусов веера обоих концов (greedy_detail::fan_radius, у точек оболочки без внешнего угла),
+//    недостающие добавляются к кандидатам.
+// Если что-то нашлось, сшивка повторяется. Итог совпадает с triangulate_fast_mesh() (точно - для
+// CrossingRule::robust; для legacy - при точках в общем положении).
+// Возвращает принятые рёбра в порядке принятия; report (если задан) - статистика по плиткам и сшивке.
+inline EdgeList triangulate_tiled_mesh(const PointSet& points, const TileOptions& options = TileOptions(),
+                                       TiledReport* report = nullptr) {
+    using clock = std::chrono::steady_clock;
+    TiledReport local;
+    TiledReport& stats = report ? *report : local;
+    stats = TiledReport();
+
+    EdgeList result;
+    const uint32_t n = uint32_t(points.size());
+    if (n < 2) {
+        return result;
+    }
+
+    WorkerPool pool(options.threads);
+    UniformGrid grid(points, 2.0);
+    size_t tiles = options.tiles ? options.tiles : 4 * size_t(pool.size());
+    tiles = std::max<size_t>(1, std::min<size_t>(tiles, options.tiles ? n / 2 : n / 1000));
+    double spacing = grid.cell / sqrt(2.0);
+    double margin = options.margin > 0 ? options.margin : 6 * spacing;
+
+    // разбиение
+    std::vector<uint32_t> tile_of(n);
+    {
+        std::vector<uint32_t> ids(n);
+        std::iota(ids.begin(), ids.end(), 0);
+        tiled_detail::kd_split(points, ids, 0, n, tiles, grid.min_x, grid.min_y, grid.max_x, grid.max_y,
+                               tile_of, stats.tiles);
+    }
+    greedy_detail::PointBuckets buckets(grid, points);
+    std::vector<uint32_t> hull_prev(n, greedy_detail::kNone);
+    std::vector<uint32_t> hull_next(n, greedy_detail::kNone);
+    greedy_detail::hull_links(points, grid, buckets, hull_prev, hull_next);
+
+    // насколько точка i глубоко в своём ядре
+    auto depth = [&](uint32_t i) {
+        const TileStats& t = stats.tiles[tile_of[i]];
+        return std::min({ points.xs[i] - t.x0, t.x1 - points.xs[i], points.ys[i] - t.y0, t.y1 - points.ys[i] });
+    };
+
+    // плитки
+    auto start = clock::now();
+    std::vector<std::vector<CandidateEdge>> found(stats.tiles.size());
+    pool.parallel_for(stats.tiles.size(), [&](size_t t) {
+        STATS_STAGE("tile");
+        auto begin = clock::now();
+        TileStats& tile = stats.tiles[t];
+        std::vector<uint32_t> ids;
+        ids.reserve(2 * tile.core_points);
+        double x0 = tile.x0 - margin, x1 = tile.x1 + margin;
+        double y0 = tile.y0 - margin, y1 = tile.y1 + margin;
+        for (int r = grid.row(y0); r <= grid.row(y1); r++) {
+            for (int c = grid.col(x0); c <= grid.col(x1); c++) {
+                int cell = grid.index(c, r);
+                for (uint32_t k = buckets.start[cell]; k < buckets.start[cell + 1]; k++) {
+                    uint32_t q = buckets.items[k];
+                    if (points.xs[q] >= x0 && points.xs[q] <= x1 && points.ys[q] >= y0 && points.ys[q] <= y1) {
+                        ids.push_back(q);
+                    }
+                }
+            }
+        }
+        // по возрастанию номеров, чтобы равные по длине рёбра шли в том же порядке, что и без плиток
+        std::sort(ids.begin(), ids.end());
+        PointSet sub;
+        sub.reserve(ids.size());
+        for (uint32_t q : ids) {
+            sub.push_back(points.xs[q], points.ys[q]);
+        }
+        std::vector<CandidateEdge>& edges = found[t];
+        triangulate_fast_stream(sub, [&](uint32_t i, uint32_t j) {
+            uint32_t a = ids[i], b = ids[j];
+            if (tile_of[a] == t || tile_of[b] == t) {
+                edges.push_back({ points.length(a, b), std::min(a, b), std::max(a, b) });
+            }
+        }, options.rule);
+        tile.points = ids.size();
+        tile.edges = edges.size();
+        tile.bytes = ids.size() * (2 * sizeof(double) + sizeof(uint32_t)) + edges.capacity() * sizeof(CandidateEdge);
+        tile.seconds = std::chrono::duration<double>(clock::now() - begin).count();
+    }, 1);
+    stats.tile_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    start = clock::now();
+    STATS_STAGE("stitch");
+    std::vector<CandidateEdge> candidates;
+    for (std::vector<CandidateEdge>& edges : found) {
+        candidates.insert(candidates.end(), edges.begin(), edges.end());
+        std::vector<CandidateEdge>().swap(edges);
+    }
+    // ребро решено в своей плитке, если оба конца в её ядре дальше margin от краёв
+    std::unordered_set<uint64_t> forced;   // рёбра, которые надо проверять при сшивке в любом случае
+    auto at_seam = [&](const CandidateEdge& e) {
+        return tile_of[e.i] != tile_of[e.j] || !(depth(e.i) > margin) || !(depth(e.j) > margin) ||
+               forced.count(tiled_detail::key(e.i, e.j));
+    };
+
+    for (;;) {
+        stats.rounds++;
+        sort_candidates(candidates, pool.size());
+        candidates.erase(std::unique(candidates.begin(), candidates.end(),
+            [](const CandidateEdge& a, const CandidateEdge& b) { return a.i == b.i && a.j == b.j; }),
+            candidates.end());
+        stats.candidates = candidates.size();
+
+        // сшивка: жадный проход, заново проверяются только рёбра у швов
+        SegmentIndex accepted(grid, options.rule);
+        accepted.reserve(candidates.size());
+        std::vector<uint32_t> taken;          // номер в candidates для каждого принятого
+        std::vector<char> seam;               // принятое ребро проверялось при сшивке
+        stats.seam = 0;
+        for (uint32_t k = 0; k < candidates.size(); k++) {
+            const CandidateEdge& e = candidates[k];
+            Point A = points[e.i];
+            Point B = points[e.j];
+            bool check = at_seam(e);
+            stats.seam += check;
+            if (check && accepted.crosses_any(A, B)) {
+                continue;
+            }
+            accepted.insert(A, B);
+            taken.push_back(k);
+            seam.push_back(check);
+        }
+
+        bool again = false;
+        // принятые у шва не должны пересекать принятые позже внутренние
+        for (uint32_t s = 0; s < taken.size(); s++) {
+            if (!seam[s]) {
+                continue;
+            }
+            const CandidateEdge& e = candidates[taken[s]];
+            for (uint32_t id : accepted.crossing(Edge(points[e.i], points[e.j]))) {
+                if (id > s && !seam[id]) {
+                    const CandidateEdge& f = candidates[taken[id]];
+                    forced.insert(tiled_detail::key(f.i, f.j));
+                    again = true;
+                }
+            }
+        }
+
+        // пары, которых нет среди рёбер, должны быть закрыты более ранним ребром
+        std::vector<std::vector<uint32_t>> adj(n);
+        for (uint32_t k : taken) {
+            adj[candidates[k].i].push_back(candidates[k].j);
+            adj[candidates[k].j].push_back(candidates[k].i);
+        }
+        for (std::vector<uint32_t>& list : adj) {
+            std::sort(list.begin(), list.end());
+        }
+        auto has_edge = [&](uint32_t a, uint32_t b) {
+            return std::binary_search(adj[a].begin(), adj[a].end(), b);
+        };
+        const double inf = std::numeric_limits<double>::infinity();
+        // проверка идёт параллельно кусками по block точек: индекс здесь только читается
+        const uint32_t block = 4096;
+        const size_t blocks = (n + block - 1) / block;
+        std::vector<double> radius(n);
+        pool.parallel_for(blocks, [&](size_t part) {
+            std::vector<std::pair<double, uint32_t>> around;
+            for (uint32_t q = uint32_t(part * block); q < std::min<size_t>(n, (part + 1) * block); q++) {
+                radius[q] = greedy_detail::fan_radius(points, q, adj[q], has_edge, around, hull_prev[q], hull_next[q]);
+            }
+        }, 1);
+        std::vector<uint32_t> open;           // точки с незакрытым веером
+        for (uint32_t q = 0; q < n; q++) {
+            if (radius[q] == inf) {
+                open.push_back(q);
+            }
+        }
+        // пара не принята, короче радиусов обоих концов и не закрыта более ранним ребром
+        auto unblocked = [&](uint32_t q, uint32_t r, CandidateEdge& e) {
+            uint32_t a = std::min(q, r), b = std::max(q, r);
+            if (has_edge(a, b)) {
+                return false;
+            }
+            e = { points.length(a, b), a, b };
+            if (e.len > std::min(radius[a], radius[b])) {
+                return false;
+            }
+            // принятые рёбра лежат в индексе в порядке принятия: номера до before - более ранние
+            uint32_t before = uint32_t(std::lower_bound(taken.begin(), taken.end(), e,
+                [&](uint32_t k, const CandidateEdge& x) { return candidate_less(candidates[k], x); }) - taken.begin());
+            return !accepted.crosses_any(points[a], points[b], 0, before);
+        };
+        std::vector<std::vector<CandidateEdge>> lost(blocks);
+        pool.parallel_for(blocks, [&](size_t part) {
+            CandidateEdge e;
+            for (uint32_t q = uint32_t(part * block); q < std::min<size_t>(n, (part + 1) * block); q++) {
+                if (radius[q] == inf) {
+                    continue;
+                }
+                double px = points.xs[q], py = points.ys[q], reach = radius[q];
+                for (int r = grid.row(py - reach); r <= grid.row(py + reach); r++) {
+                    for (int c = grid.col(px - reach); c <= grid.col(px + reach); c++) {
+                        int cell = grid.index(c, r);
+                        for (uint32_t k = buckets.start[cell]; k < buckets.start[cell + 1]; k++) {
+                            uint32_t x = buckets.items[k];
+                            // пару двух закрытых точек берём один раз, с незакрытой - отсюда
+                            if (x != q && (radius[x] == inf || x > q) && unblocked(q, x, e)) {
+                                lost[part].push_back(e);
+                            }
+                        }
+                    }
+                }
+            }
+        }, 1);
+        std::vector<CandidateEdge> missing;
+        for (std::vector<CandidateEdge>& part : lost) {
+            missing.insert(missing.end(), part.begin(), part.end());
+        }
+        // пары двух незакрытых точек: сначала только в соседних клетках; все пары - если незакрытых
+        // меньше sqrt(n) или больше ничего не нашлось (раунд последний, угол снаружи оболочки не в счёт)
+        CandidateEdge e;
+        bool all_pairs = open.size() * open.size() <= n;
+        for (size_t a = 0; a < open.size() && !all_pairs; a++) {
+            uint32_t q = open[a];
+            int row = grid.row(points.ys[q]), col = grid.col(points.xs[q]);
+            for (int r = std::max(row - 1, 0); r <= std::min(row + 1, grid.rows - 1); r++) {
+                for (int c = std::max(col - 1, 0); c <= std::min(col + 1, grid.cols - 1); c++) {
+                    int cell = grid.index(c, r);
+                    for (uint32_t k = buckets.start[cell]; k < buckets.start[cell + 1]; k++) {
+                        uint32_t x = buckets.items[k];
+                        if (x > q && radius[x] == inf && unblocked(q, x, e)) {
+                            missing.push_back(e);
+                        }
+                    }
+                }
+            }
+        }
+        if (all_pairs || missing.empty()) {
+            for (size_t a = 0; a < open.size(); a++) {
+                for (size_t b = a + 1; b < open.size(); b++) {
+                    if (unblocked(open[a], open[b], e)) {
+                        missing.push_back(e);
+                    }
+                }
+            }
+        }
+        for (const CandidateEdge& e : missing) {
+            forced.insert(tiled_detail::key(e.i, e.j));
+        }
+        stats.added += missing.size();
+        candidates.insert(candidates.end(), missing.begin(), missing.end());
+
+        if (!again && missing.empty()) {
+            result.reserve(taken.size());
+            for (uint32_t k : taken) {
+                result.push_back(candidates[k].i, candidates[k].j);
+            }
+            break;
+        }
+    }
+    stats.stitch_seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return result;
+}
+
+inline std::vector<Edge> triangulate_tiled(const std::vector<Point>& points, const TileOptions& options = TileOptions()) {
+    Mesh mesh;
+    mesh.points = PointSet(points);
+    mesh.edges = triangulate_tiled_mesh(mesh.points, options);
+    return mesh.to_edges();
+}
@@ -0,0 +1,551 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "segment_index.hpp"
+#include "edge_sort.hpp"
+#include "predicates.hpp"
+#include "arena.hpp"
+
+
+//все пары точек - кандидаты в рёбра, с длинами (ещё не отсортированы); память edges переиспользуется
+inline void make_candidates(const PointSet& points, std::vector<CandidateEdge>& edges) {
+    STATS_STAGE("candidates");
+    edges.clear();
+    const uint32_t n = uint32_t(points.size());
+    if (n < 2) {
+        return;
+    }
+    edges.reserve(size_t(n) * (n - 1) / 2);
+    for (uint32_t i = 0; i < n - 1; i++) {
+        for (uint32_t j = i + 1; j < n; j++) {
+            edges.push_back({ points.length(i, j), i, j });
+        }
+    }
+    STATS_COUNT(candidates, edges.size());
+}
+
+inline std::vector<CandidateEdge> make_candidates(const PointSet& points) {
+    std::vector<CandidateEdge> edges;
+    make_candidates(points, edges);
+    return edges;
+}
+
+//отсортированные кандидаты проверяются на пересечение с уже принятыми рёбрами
+//принятые рёбра лежат в сеточном индексе, поэтому кандидат сравнивается только с рёбрами рядом с ним
+//accepted - индекс принятых рёбер, очищается здесь (его ячейки можно переиспользовать между запусками)
+inline EdgeList filter_candidates(const PointSet& points, const std::vector<CandidateEdge>& edges,
+                                  CrossingRule rule, SegmentIndex& accepted) {
+    STATS_STAGE("filter");
+    EdgeList result;
+    accepted.reset(UniformGrid(points, 2.0), rule);
+    accepted.reserve(3 * points.size());
+    result.reserve(edges.size());
+    for (const CandidateEdge& e : edges) {
+        Point A = points[e.i];
+        Point B = points[e.j];
+        // тут проверить на пересечение со всеми текущими подходящими ребрами, и если вдруг пересекает -> verification = false;
+        bool ok = !accepted.crosses_any(A, B);
+        if (ok) {
+            accepted.insert(A, B);
+        }
+        result.push_back(e.i, e.j, ok);
+    }
+    STATS_COUNT(accepted, accepted.size());
+    STATS_COUNT(rejected, edges.size() - accepted.size());
+    return result;
+}
+
+inline EdgeList filter_candidates(const PointSet& points, const std::vector<CandidateEdge>& edges,
+                                  CrossingRule rule = CrossingRule::legacy) {
+    SegmentIndex accepted;
+    return filter_candidates(points, edges, rule, accepted);
+}
+
+//функция создания триангуляции (списка валидных и невалидных отрезков)
+//рёбра - пары номеров точек в порядке возрастания длины, verification - принято ли ребро;
+//кандидат проверяется только с принятыми рёбрами (triangulate_reference(points, true))
+//threads - число потоков для сортировки рёбер (0 - по числу ядер), rule - правило пересечения
+inline EdgeList triangulate_mesh(const PointSet& points, unsigned threads = 0,
+                                 CrossingRule rule = CrossingRule::legacy) {
+    std::vector<CandidateEdge> edges = make_candidates(points);
+    // Cортируем ребра по длине по возрастанию (длины считаются один раз, равные остаются в исходном порядке)
+    sort_candidates(edges, threads);
+    return filter_candidates(points, edges, rule);
+}
+
+//то же в старом виде: список рёбер с копиями точек
+inline std::vector<Edge> triangulate(const std::vector<Point>& points, unsigned threads = 0,
+                                     CrossingRule rule = CrossingRule::legacy) {
+    Mesh mesh;
+    mesh.points = PointSet(points);
+    mesh.edges = triangulate_mesh(mesh.points, threads, rule);
+    return mesh.to_edges();
+}
+
+//исходная жадная триангуляция курсовой, без ускорений - эталон для проверки на малых наборах (O(n^4)):
+//все пары по возрастанию длины (равные - в исходном порядке, как после пузырька), каждая проверяется
+//старым segments_cross со всеми уже рассмотренными рёбрами - и с принятыми, и с отклонёнными.
+//skip_rejected - отклонённые рёбра кандидатов не закрывают, как и задумано в курсовой ("со всеми текущими
+//подходящими"): отклонённое ребро в триангуляцию не входит, и то, что оно пересекает, пересекать можно.
+//Так считают triangulate() и все ускоренные движки.
+inline std::vector<Edge> triangulate_reference(const std::vector<Point>& points, bool skip_rejected = false) {
+    std::vector<Edge> edges;
+    std::vector<Edge> result;
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        for (size_t j = i + 1; j < points.size(); j++) {
+            edges.push_back(Edge(points[i], points[j]));
+        }
+    }
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge& l, const Edge& r) {
+        return l.length() < r.length();
+    });
+    result.reserve(edges.size());
+    for (Edge& e : edges) {
+        for (const Edge& r : result) {
+            if (skip_rejected && !r.verification) {
+                continue;
+            }
+            if (segments_cross(e.A_.x_, e.A_.y_, e.B_.x_, e.B_.y_, r.A_.x_, r.A_.y_, r.B_.x_, r.B_.y_)) {
+                e.verification = false;
+            }
+        }
+        result.push_back(e);
+    }
+    return result;
+}
+
+
+namespace greedy_detail {
+
+const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+// точный знак поворота a -> b -> c: от него зависит, какие точки выбывают, ошибаться здесь нельзя
+inline int orient(const PointSet& p, uint32_t a, uint32_t b, uint32_t c) {
+    return predicates::orient2d(p.xs[a], p.ys[a], p.xs[b], p.ys[b], p.xs[c], p.ys[c]);
+}
+
+// Радиус веера R(p): если все углы вокруг p закрыты треугольниками из принятых рёбер, то наибольшая
+// сторона этих треугольников, иначе бесконечность. Пара p-x длиннее R(p) выходит из веера через сторону
+// или вершину, то есть её закрывает более раннее ребро (точно - для CrossingRule::robust).
+// Для точки на оболочке внешний угол (hull_prev, hull_next) можно не закрывать: туда пар нет.
+template <class Neighbours, class HasEdge>
+double fan_radius(const PointSet& p, uint32_t q, const Neighbours& adj, HasEdge&& has_edge,
+                  std::vector<std::pair<double, uint32_t>>& around,
+                  uint32_t hull_prev = kNone, uint32_t hull_next = kNone) {
+    const double inf = std::numeric_limits<double>::infinity();
+    if (adj.size() < (hull_prev == kNone ? 3u : 2u)) {
+        return inf;
+    }
+    around.clear();
+    for (uint32_t r : adj) {
+        around.push_back({ atan2(p.ys[r] - p.ys[q], p.xs[r] - p.xs[q]), r });
+    }
+    std::sort(around.begin(), around.end());
+    double radius = 0;
+    for (size_t k = 0; k < around.size(); k++) {
+        uint32_t a = around[k].second;
+        uint32_t b = around[(k + 1) % around.size()].second;
+        radius = std::max(radius, p.length(q, a));
+        if (a == hull_prev && b == hull_next) {
+            continue;
+        }
+        if (orient(p, q, a, b) <= 0 || !has_edge(a, b)) {
+            return inf;
+        }
+        radius = std::max(radius, p.length(a, b));
+    }
+    return radius;
+}
+
+// курсор ленивого перебора пар одной точки (lazy_triangulation.hpp): радиус поиска
+// и несколько следующих пар, найденных за один просмотр
+struct PairCursor {
+    static const int kBatch = 8;
+
+    double reach;
+    uint32_t next[kBatch];
+    uint8_t size;
+    uint8_t pos;
+};
+
+// точки, разложенные по ячейкам сетки (CSR)
+struct PointBuckets {
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> items;
+
+    PointBuckets() = default;
+
+    PointBuckets(const UniformGrid& grid, const PointSet& points) {
+        build(grid, points);
+    }
+
+    // разложить заново в ту же память
+    void build(const UniformGrid& grid, const PointSet& points) {
+        start.assign(grid.size() + 1, 0);
+        for (uint32_t i = 0; i < points.size(); i++) {
+            start[grid.index(grid.col(points.xs[i]), grid.row(points.ys[i])) + 1]++;
+        }
+        for (size_t c = 0; c + 1 < start.size(); c++) {
+            start[c + 1] += start[c];
+        }
+        // start[c] сдвигается до конца ячейки c, потом возвращается на место
+        items.resize(points.size());
+        for (uint32_t i = 0; i < points.size(); i++) {
+            items[start[grid.index(grid.col(points.xs[i]), grid.row(points.ys[i]))]++] = i;
+        }
+        for (size_t c = start.size() - 1; c > 0; c--) {
+            start[c] = start[c - 1];
+        }
+        start[0] = 0;
+    }
+};
+
+// Списки соседей всех точек в одной арене. У точки участок на slots номеров; когда он полон,
+// список переезжает в участок вдвое больше, а старый просто лежит до reset арены.
+class NeighbourLists {
+public:
+    struct Range {
+        const uint32_t* first;
+        const uint32_t* last;
+
+        const uint32_t* begin() const {
+            return first;
+        }
+
+        const uint32_t* end() const {
+            return last;
+        }
+
+        size_t size() const {
+            return size_t(last - first);
+        }
+    };
+
+    // сколько байт арены нужно на n точек без переездов
+    static size_t bytes(size_t n, uint32_t slots = 8) {
+        return n * (sizeof(uint32_t*) + 2 * sizeof(uint32_t) + slots * sizeof(uint32_t)) + 64;
+    }
+
+    // n пустых списков
+    void assign(BumpArena& arena, uint32_t n, uint32_t slots = 8) {
+        arena_ = &arena;
+        data_ = arena.allocate<uint32_t*>(n);
+        size_ = arena.allocate<uint32_t>(n);
+        capacity_ = arena.allocate<uint32_t>(n);
+        uint32_t* all = arena.allocate<uint32_t>(size_t(n) * slots);
+        for (uint32_t p = 0; p < n; p++) {
+            data_[p] = all + size_t(p) * slots;
+            size_[p] = 0;
+            capacity_[p] = slots;
+        }
+    }
+
+    void push_back(uint32_t p, uint32_t q) {
+        if (size_[p] == capacity_[p]) {
+            uint32_t* grown = arena_->allocate<uint32_t>(2 * size_t(capacity_[p]));
+            std::copy(data_[p], data_[p] + size_[p], grown);
+            data_[p] = grown;
+            capacity_[p] *= 2;
+        }
+        data_[p][size_[p]++] = q;
+    }
+
+    bool contains(uint32_t p, uint32_t q) const {
+        return std::find(data_[p], data_[p] + size_[p], q) != data_[p] + size_[p];
+    }
+
+    Range operator[](uint32_t p) const {
+        return { data_[p], data_[p] + size_[p] };
+    }
+
+private:
+    BumpArena* arena_ = nullptr;
+    uint32_t** data_ = nullptr;
+    uint32_t* size_ = nullptr;
+    uint32_t* capacity_ = nullptr;
+};
+
+// соседи по выпуклой оболочке (против часовой стрелки), включая точки, лежащие на её сторонах
+inline void hull_links(const PointSet& points, const UniformGrid& grid, const PointBuckets& buckets,
+                       std::vector<uint32_t>& prev, std::vector<uint32_t>& next) {
+    std::vector<uint32_t> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return points.xs[a] < points.xs[b] || (points.xs[a] == points.xs[b] && points.ys[a] < points.ys[b]);
+    });
+    std::vector<uint32_t> hull(2 * order.size());
+    size_t k = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        while (k >= 2 && orient(points, hull[k - 2], hull[k - 1], order[i]) <= 0) {
+            k--;
+        }
+        hull[k++] = order[i];
+    }
+    for (size_t i = order.size() - 1, t = k + 1; i > 0; i--) {
+        while (k >= t && orient(points, hull[k - 2], hull[k - 1], order[i - 1]) <= 0) {
+            k--;
+        }
+        hull[k++] = order[i - 1];
+    }
+    hull.resize(k - 1);
+    // все точки на одной прямой: внешней области нет, оставляем всех без соседей по оболочке
+    if (hull.size() < 3) {
+        return;
+    }
+
+    std::vector<std::pair<double, uint32_t>> on_side;
+    for (size_t i = 0; i < hull.size(); i++) {
+        uint32_t u = hull[i];
+        uint32_t w = hull[(i + 1) % hull.size()];
+        double ux = points.xs[u], uy = points.ys[u];
+        double wx = points.xs[w], wy = points.ys[w];
+        on_side.clear();
+        grid.for_each_cell(points[u], points[w], [&](int c) {
+            for (uint32_t j = buckets.start[c]; j < buckets.start[c + 1]; j++) {
+                uint32_t q = buckets.items[j];
+                if (orient(points, u, w, q) != 0) {
+                    continue;
+                }
+                double t = (points.xs[q] - ux) * (wx - ux) + (points.ys[q] - uy) * (wy - uy);
+                double s = (points.xs[q] - wx) * (ux - wx) + (points.ys[q] - wy) * (uy - wy);
+                if (t > 0 && s > 0) {
+                    on_side.push_back({ t, q });
+                }
+            }
+        });
+        std::sort(on_side.begin(), on_side.end());
+        uint32_t last = u;
+        for (auto& item : on_side) {
+            next[last] = item.second;
+            prev[item.second] = last;
+            last = item.second;
+        }
+        next[last] = w;
+        prev[w] = last;
+    }
+}
+
+}
+
+
+// Буферы одного запуска триангуляции. Между запусками они только очищаются, память остаётся,
+// поэтому повторные запуски на наборах похожего размера (сервер, DynamicTriangulation) почти
+// не обращаются к куче. Только перемещается: копия буферов никому не нужна.
+struct TriangulationWorkspace {
+    BumpArena arena;                                  // списки соседей
+    std::vector<CandidateEdge> candidates;            // кандидаты: все пары, текущая полоса или куча курсоров
+    SegmentIndex accepted;                            // принятые рёбра
+    greedy_detail::PointBuckets buckets;
+    std::vector<uint32_t> hull_prev;
+    std::vector<uint32_t> hull_next;
+    std::vector<char> alive;
+    std::vector<uint32_t> alive_list;
+    std::vector<std::pair<double, uint32_t>> around;
+    std::vector<greedy_detail::PairCursor> cursors;   // курсоры пар (triangulate_lazy_stream)
+
+    TriangulationWorkspace() = default;
+    TriangulationWorkspace(TriangulationWorkspace&&) = default;
+    TriangulationWorkspace& operator=(TriangulationWorkspace&&) = default;
+    TriangulationWorkspace(const TriangulationWorkspace&) = delete;
+    TriangulationWorkspace& operator=(const TriangulationWorkspace&) = delete;
+};
+
+//то же, что triangulate_mesh, но промежуточные буферы (кандидаты, индекс рёбер) берутся из workspace
+inline EdgeList triangulate_mesh(const PointSet& points, unsigned threads, CrossingRule rule,
+                                 TriangulationWorkspace& workspace) {
+    make_candidates(points, workspace.candidates);
+    sort_candidates(workspace.candidates, threads);
+    return filter_candidates(points, workspace.candidates, rule, workspace.accepted);
+}
+
+
+// Жадная триангуляция без перебора всех пар сразу.
+// Пары точек рассматриваются полосами по длине (lo, hi], hi удваивается; внутри полосы порядок тот же,
+// что и у triangulate() (длина, затем индексы). Точка выбывает, как только все углы между её рёбрами
+// закрыты треугольниками (и внешний угол на оболочке): новых рёбер из неё уже не будет.
+// Принятые рёбра хранятся в сетке, поэтому кандидат проверяется только с рёбрами рядом с ним.
+// Принятые рёбра отдаются в sink(i, j) сразу, в порядке принятия (совпадают с рёбрами triangulate()
+// с verification == true); списка рёбер здесь нет, но принятые рёбра всё равно лежат в индексе (SegmentIndex)
+// и списках соседей - O(n) вместе с точками, сеткой и текущей полосой.
+// Буферы берутся из workspace, его можно передавать в следующие запуски.
+// blocked(i, j) - дополнительный запрет пары (рёбра, которых нет среди точек, но которые её закрывают:
+// DynamicTriangulation пересчитывает так кусок триангуляции при оставшихся вокруг рёбрах). Он только
+// отклоняет пары, поэтому выбывание точек остаётся верным.
+// Выбывание точки верно только для точной проверки, поэтому rule по умолчанию - robust. С legacy
+// (наложение на одной прямой и касание концом - не пересечение) рёбра совпадают с triangulate() лишь
+// для точек в общем положении, без трёх на одной прямой; на сетках, кластерах, наборах с прямыми
+// они другие (engine_compare --legacy --check).
+template <class Sink, class Blocked>
+void triangulate_fast_stream(const PointSet& points, Sink&& sink, CrossingRule rule,
+                             TriangulationWorkspace& workspace, Blocked&& blocked) {
+    using namespace greedy_detail;
+    STATS_STAGE("fast");
+
+    const uint32_t n = uint32_t(points.size());
+    if (n < 2) {
+        return;
+    }
+
+    UniformGrid grid(points, 2.0);
+    PointBuckets& buckets = workspace.buckets;
+    buckets.build(grid, points);
+    SegmentIndex& accepted = workspace.accepted;
+    accepted.reset(grid, rule);
+    accepted.reserve(3 * size_t(n));
+
+    std::vector<uint32_t>& hull_prev = workspace.hull_prev;
+    std::vector<uint32_t>& hull_next = workspace.hull_next;
+    hull_prev.assign(n, kNone);
+    hull_next.assign(n, kNone);
+    hull_links(points, grid, buckets, hull_prev, hull_next);
+
+    workspace.arena.reset();
+    workspace.arena.reserve(NeighbourLists::bytes(n));
+    NeighbourLists adj;
+    adj.assign(workspace.arena, n);
+    std::vector<char>& alive = workspace.alive;
+    alive.assign(n, 1);
+    std::vector<uint32_t>& alive_list = workspace.alive_list;
+    alive_list.resize(n);
+    std::iota(alive_list.begin(), alive_list.end(), 0);
+
+    auto has_edge = [&](uint32_t a, uint32_t b) {
+        return adj.contains(a, b);
+    };
+
+    std::vector<std::pair<double, uint32_t>>& around = workspace.around;
+    // все углы вокруг p закрыты треугольниками из принятых рёбер?
+    auto closed = [&](uint32_t p) {
+        if (adj[p].size() < 2) {
+            return false;
+        }
+        around.clear();
+        for (uint32_t q : adj[p]) {
+            around.push_back({ atan2(points.ys[q] - points.ys[p], points.xs[q] - points.xs[p]), q });
+        }
+        std::sort(around.begin(), around.end());
+        for (size_t k = 0; k < around.size(); k++) {
+            uint32_t a = around[k].second;
+            uint32_t b = around[(k + 1) % around.size()].second;
+            if (a == hull_prev[p] && b == hull_next[p]) {
+                continue;
+            }
+            if (orient(points, p, a, b) <= 0 || !has_edge(a, b)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    auto retire = [&](uint32_t p) {
+        if (alive[p] && closed(p)) {
+            alive[p] = 0;
+        }
+    };
+
+    std::vector<CandidateEdge>& band = workspace.candidates;
+
+    const double diag = grid.diagonal();
+    const double inf = std::numeric_limits<double>::infinity();
+    double lo = -1;
+    double hi = grid.cell < diag ? grid.cell : inf;
+
+    while (!alive_list.empty()) {
+        band.clear();
+        for (uint32_t p : alive_list) {
+            double px = points.xs[p], py = points.ys[p];
+            int c0 = grid.col(px - hi), c1 = grid.col(px + hi);
+            int r0 = grid.row(py - hi), r1 = grid.row(py + hi);
+            for (int r = r0; r <= r1; r++) {
+                for (int c = c0; c <= c1; c++) {
+                    int cell = grid.index(c, r);
+                    for (uint32_t k = buckets.start[cell]; k < buckets.start[cell + 1]; k++) {
+                        uint32_t q = buckets.items[k];
+                        if (q <= p || !alive[q]) {
+                            continue;
+                        }
+                        double len = points.length(p, q);
+                        if (len > lo && len <= hi) {
+                            band.push_back({ len, p, q });
+                        }
+                    }
+                }
+            }
+        }
+
+        STATS_COUNT(candidates, band.size());
+        sort_candidates(band);
+
+        for (const CandidateEdge& c : band) {
+            if (!alive[c.i] || !alive[c.j]) {
+                continue;
+            }
+            Point A = points[c.i];
+            Point B = points[c.j];
+            if (accepted.crosses_any(A, B) || blocked(c.i, c.j)) {
+                STATS_COUNT(rejected, 1);
+                continue;
+            }
+            STATS_COUNT(accepted, 1);
+            accepted.insert(A, B);
+            sink(c.i, c.j);
+            adj.push_back(c.i, c.j);
+            adj.push_back(c.j, c.i);
+            retire(c.i);
+            retire(c.j);
+            for (uint32_t x : adj[c.i]) {
+                if (has_edge(x, c.j)) {
+                    retire(x);
+                }
+            }
+        }
+
+        if (hi == inf) {
+            break;
+        }
+        lo = hi;
+        hi = hi * 2 < diag ? hi * 2 : inf;
+        alive_list.erase(std::remove_if(alive_list.begin(), alive_list.end(),
+            [&](uint32_t p) { return !alive[p]; }), alive_list.end());
+    }
+}
+
+template <class Sink>
+void triangulate_fast_stream(const PointSet& points, Sink&& sink, CrossingRule rule,
+                             TriangulationWorkspace& workspace) {
+    triangulate_fast_stream(points, sink, rule, workspace, [](uint32_t, uint32_t) { return false; });
+}
+
+template <class Sink>
+void triangulate_fast_stream(const PointSet& points, Sink&& sink, CrossingRule rule = CrossingRule::robust) {
+    TriangulationWorkspace workspace;
+    triangulate_fast_stream(points, sink, rule, workspace);
+}
+
+// то же, но рёбра собираются в список
+inline EdgeList triangulate_fast_mesh(const PointSet& points, CrossingRule rule,
+                                      TriangulationWorkspace& workspace) {
+    EdgeList result;
+    result.reserve(3 * points.size());
+    triangulate_fast_stream(points, [&](uint32_t i, uint32_t j) { result.push_back(i, j); }, rule, workspace);
+    return result;
+}
+
+inline EdgeList triangulate_fast_mesh(const PointSet& points, CrossingRule rule = CrossingRule::robust) {
+    TriangulationWorkspace workspace;
+    return triangulate_fast_mesh(points, rule, workspace);
+}
+
+inline std::vector<Edge> triangulate_fast(const std::vector<Point>& points, CrossingRule rule = CrossingRule::robust) {
+    Mesh mesh;
+    mesh.points = PointSet(points);
+    mesh.edges = triangulate_fast_mesh(mesh.points, rule);
+    return mesh.to_edges();
+}
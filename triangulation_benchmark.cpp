@@ -0,0 +1,330 @@
+// Замеры по этапам на синтетических наборах точек.
+// Запуск: triangulation_benchmark [ключи], см. usage(). Результат - CSV (по строке на этап),
+// в stdout или в файл --out; ход работы печатается в stderr.
+// Этапы:
+//   candidates - все пары точек с длинами, sort - их сортировка, filter - проверка пересечений
+//   (вместе это triangulate_mesh; только для n <= --pairs-limit, память O(n^2));
+//   fast - triangulate_fast_stream, lazy - triangulate_lazy_stream, tiled - triangulate_tiled_mesh, restricted - triangulate_candidates_mesh
+//   (жадный проход по рёбрам Делоне с проверкой; для любых n);
+//   render - кадры OpenCV без окна, tikz - LaTeX-файл (по результату filter, n <= --draw-limit);
+//   radii - проверка перебором, что радиусы вееров (greedy_detail::fan_radius) верны: items - число
+//   нарушений, должно быть 0 (n <= --radii-limit).
+// Этап, который на каком-то n занял больше --budget секунд, для больших n этого распределения пропускается.
+// Без OpenCV (-DCOURSEWORK_NO_OPENCV) этап render не выполняется.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "tiled_triangulation.hpp"
+#include "candidate_triangulation.hpp"
+#include "lazy_triangulation.hpp"
+#include "tikz_output.hpp"
+#include "point_generators.hpp"
+#ifndef COURSEWORK_NO_OPENCV
+#include "render.hpp"
+#endif
+
+
+struct BenchmarkOptions {
+    std::vector<Distribution> distributions = all_distributions();
+    std::vector<size_t> sizes = { 10, 100, 1000, 10000, 100000, 1000000 };
+    unsigned seed = 1;
+    int repeat = 3;
+    unsigned threads = 0;
+    CrossingRule rule = CrossingRule::legacy;
+    size_t pairs_limit = 4000;    //candidates/sort/filter: n(n-1)/2 кандидатов по 16 байт
+    size_t draw_limit = 1000;     //render/tikz: по кадру на кандидата
+    size_t radii_limit = 200;     //radii: перебор всех пар против всех рёбер, O(n^3)
+    double budget = 60;           //секунд на этап, дальше этот этап для больших n не запускается
+    std::string out;
+    std::string tikz_file = "triangulation_benchmark.tex";
+};
+
+static void usage() {
+    std::cout << "usage: triangulation_benchmark [options]\n"
+        "  --dist LIST        distributions, comma separated: uniform,clustered,grid,collinear,circle (default all)\n"
+        "  --n LIST           point counts, comma separated (default 10,100,1000,10000,100000,1000000)\n"
+        "  --seed S           generator seed (default 1)\n"
+        "  --repeat R         runs per stage; min and mean are reported (default 3)\n"
+        "  --threads T        threads for sorting and tiles (0 - all cores)\n"
+        "  --robust           exact predicates instead of the legacy crossing test\n"
+        "  --pairs-limit N    largest n for the all-pairs stages candidates/sort/filter (default 4000)\n"
+        "  --draw-limit N     largest n for render and tikz (default 1000)\n"
+        "  --radii-limit N    largest n for the brute-force fan radius check radii (default 200)\n"
+        "  --budget S         skip a stage for larger n once one run took longer than S seconds (default 60)\n"
+        "  --tikz-file F      scratch file for the tikz stage (default triangulation_benchmark.tex, removed after)\n"
+        "  --out FILE         write CSV to FILE instead of stdout\n";
+}
+
+static bool parse_list(const std::string& text, std::vector<std::string>& items) {
+    std::stringstream in(text);
+    std::string item;
+    items.clear();
+    while (std::getline(in, item, ',')) {
+        if (item.empty()) {
+            return false;
+        }
+        items.push_back(item);
+    }
+    return !items.empty();
+}
+
+static bool parse_options(int argc, char** argv, BenchmarkOptions& options) {
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        bool has_value = k + 1 < argc;
+        std::vector<std::string> items;
+        if (arg == "--dist" && has_value) {
+            if (!parse_list(argv[++k], items)) {
+                return false;
+            }
+            options.distributions.clear();
+            for (const std::string& name : items) {
+                Distribution d;
+                if (!parse_distribution(name, d)) {
+                    std::cerr << "unknown distribution " << name << "\n";
+                    return false;
+                }
+                options.distributions.push_back(d);
+            }
+        }
+        else if (arg == "--n" && has_value) {
+            if (!parse_list(argv[++k], items)) {
+                return false;
+            }
+            options.sizes.clear();
+            for (const std::string& item : items) {
+                options.sizes.push_back(size_t(std::atof(item.c_str())));
+            }
+        }
+        else if (arg == "--seed" && has_value) {
+            options.seed = unsigned(std::atol(argv[++k]));
+        }
+        else if (arg == "--repeat" && has_value) {
+            options.repeat = std::max(1, std::atoi(argv[++k]));
+        }
+        else if (arg == "--threads" && has_value) {
+            options.threads = unsigned(std::atoi(argv[++k]));
+        }
+        else if (arg == "--robust") {
+            options.rule = CrossingRule::robust;
+        }
+        else if (arg == "--pairs-limit" && has_value) {
+            options.pairs_limit = size_t(std::atof(argv[++k]));
+        }
+        else if (arg == "--draw-limit" && has_value) {
+            options.draw_limit = size_t(std::atof(argv[++k]));
+        }
+        else if (arg == "--radii-limit" && has_value) {
+            options.radii_limit = size_t(std::atof(argv[++k]));
+        }
+        else if (arg == "--budget" && has_value) {
+            options.budget = std::atof(argv[++k]);
+        }
+        else if (arg == "--tikz-file" && has_value) {
+            options.tikz_file = argv[++k];
+        }
+        else if (arg == "--out" && has_value) {
+            options.out = argv[++k];
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Перебором проверяет то, на что опираются движки при выбывании точек: если принята часть рёбер
+// (первые k в порядке принятия), то пару q-x, которой среди них нет и которая длиннее радиуса веера R(q)
+// по этим рёбрам (для точки оболочки - без внешнего угла), пересекает одно из них. На итоговом наборе
+// рёбер это верно всегда, поэтому проверяются восемь промежуточных k. Рёбра - triangulate_fast_stream,
+// пересечение всегда точное (CrossingRule::robust): только для него радиусы и верны.
+// Возвращает число нарушений.
+static size_t count_radius_violations(const PointSet& points) {
+    using namespace greedy_detail;
+    const uint32_t n = uint32_t(points.size());
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    triangulate_fast_stream(points, [&](uint32_t i, uint32_t j) { edges.push_back({ i, j }); },
+                            CrossingRule::robust);
+
+    UniformGrid grid(points, 2.0);
+    PointBuckets buckets(grid, points);
+    std::vector<uint32_t> hull_prev(n, kNone), hull_next(n, kNone);
+    if (n >= 2) {
+        hull_links(points, grid, buckets, hull_prev, hull_next);
+    }
+    std::vector<std::pair<double, uint32_t>> around;
+    size_t violations = 0;
+    const size_t parts = 8;
+    for (size_t part = 1; part <= parts; part++) {
+        size_t k = edges.size() * part / parts;
+        std::vector<std::vector<uint32_t>> adj(n);
+        for (size_t e = 0; e < k; e++) {
+            adj[edges[e].first].push_back(edges[e].second);
+            adj[edges[e].second].push_back(edges[e].first);
+        }
+        for (std::vector<uint32_t>& list : adj) {
+            std::sort(list.begin(), list.end());
+        }
+        auto has_edge = [&](uint32_t a, uint32_t b) {
+            return std::binary_search(adj[a].begin(), adj[a].end(), b);
+        };
+        for (uint32_t q = 0; q < n; q++) {
+            double radius = fan_radius(points, q, adj[q], has_edge, around, hull_prev[q], hull_next[q]);
+            for (uint32_t x = 0; x < n; x++) {
+                if (x == q || has_edge(q, x) || !(points.length(q, x) > radius)) {
+                    continue;
+                }
+                bool blocked = false;
+                for (size_t e = 0; e < k && !blocked; e++) {
+                    uint32_t i = edges[e].first, j = edges[e].second;
+                    blocked = predicates::segments_conflict(points.xs[q], points.ys[q], points.xs[x], points.ys[x],
+                                                            points.xs[i], points.ys[i], points.xs[j], points.ys[j]);
+                }
+                violations += !blocked;
+            }
+        }
+    }
+    return violations;
+}
+
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    std::ofstream file;
+    if (!options.out.empty()) {
+        file.open(options.out, std::ofstream::out | std::ofstream::trunc);
+        if (!file.is_open()) {
+            std::cerr << "error: cannot open " << options.out << "\n";
+            return 1;
+        }
+    }
+    std::ostream& csv = options.out.empty() ? std::cout : file;
+    // items - что получилось на выходе этапа: кандидатов, рёбер, кадров или байт LaTeX
+    csv << "distribution,n,stage,repeat,seconds_min,seconds_mean,items\n";
+
+    for (Distribution d : options.distributions) {
+        std::set<std::string> over_budget;
+        for (size_t n : options.sizes) {
+            PointSet points = generate_points(d, n, options.seed);
+
+            // один этап: repeat запусков, run() возвращает items
+            auto stage = [&](const std::string& name, auto&& run) {
+                if (over_budget.count(name)) {
+                    std::cerr << distribution_name(d) << " n=" << n << " " << name << ": skipped (over budget)\n";
+                    return;
+                }
+                double best = 0, total = 0;
+                size_t items = 0;
+                int runs = 0;
+                for (int r = 0; r < options.repeat; r++) {
+                    auto start = std::chrono::steady_clock::now();
+                    items = run();
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    best = r == 0 ? seconds : std::min(best, seconds);
+                    total += seconds;
+                    runs++;
+                    if (seconds > options.budget) {
+                        over_budget.insert(name);
+                        break;
+                    }
+                }
+                csv << distribution_name(d) << "," << n << "," << name << "," << runs << ","
+                    << best << "," << total / runs << "," << items << "\n";
+                csv.flush();
+                std::cerr << distribution_name(d) << " n=" << n << " " << name << ": " << best << " s\n";
+            };
+
+            // три этапа полного перебора идут только вместе: каждый берёт результат предыдущего
+            Mesh mesh;
+            bool pairs = n <= options.pairs_limit && !over_budget.count("candidates") &&
+                         !over_budget.count("sort") && !over_budget.count("filter");
+            if (pairs) {
+                std::vector<CandidateEdge> candidates;
+                stage("candidates", [&] {
+                    candidates = make_candidates(points);
+                    return candidates.size();
+                });
+                std::vector<CandidateEdge> sorted;
+                stage("sort", [&] {
+                    sorted = candidates;
+                    sort_candidates(sorted, options.threads);
+                    return sorted.size();
+                });
+                stage("filter", [&] {
+                    mesh.edges = filter_candidates(points, sorted, options.rule);
+                    size_t accepted = 0;
+                    for (size_t k = 0; k < mesh.edges.size(); k++) {
+                        accepted += mesh.edges.verification[k];
+                    }
+                    return accepted;
+                });
+                mesh.points = points;
+            }
+
+            stage("fast", [&] {
+                size_t count = 0;
+                triangulate_fast_stream(points, [&](uint32_t, uint32_t) { count++; }, options.rule);
+                return count;
+            });
+            stage("lazy", [&] {
+                size_t count = 0;
+                triangulate_lazy_stream(points, [&](uint32_t, uint32_t, bool ok) { count += ok; }, options.rule);
+                return count;
+            });
+            stage("tiled", [&] {
+                TileOptions tiling;
+                tiling.threads = options.threads;
+                tiling.rule = options.rule;
+                return triangulate_tiled_mesh(points, tiling).size();
+            });
+            stage("restricted", [&] {
+                CandidateOptions source;
+                source.rule = options.rule;
+                return triangulate_candidates_mesh(points, source).size();
+            });
+
+            if (n <= options.radii_limit) {
+                stage("radii", [&] {
+                    size_t violations = count_radius_violations(points);
+                    if (violations > 0) {
+                        std::cerr << distribution_name(d) << " n=" << n << " radii: " << violations
+                                  << " pairs longer than the fan radius are not crossed\n";
+                    }
+                    return violations;
+                });
+            }
+
+            if (n <= options.draw_limit && mesh.edges.size() > 0) {
+#ifndef COURSEWORK_NO_OPENCV
+                stage("render", [&] {
+                    RenderOptions render;
+                    render.show = false;
+                    render_steps(mesh, render);
+                    return mesh.edges.size();
+                });
+#endif
+                stage("tikz", [&] {
+                    std::ofstream fout(options.tikz_file, std::ofstream::out | std::ofstream::trunc);
+                    write_tikz(mesh, fout);
+                    return size_t(fout.tellp());
+                });
+                std::remove(options.tikz_file.c_str());
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+// Долгоживущий сервис: принимает наборы точек и возвращает принятые рёбра жадной триангуляции,
+// чтобы не платить за запуск процесса на каждый небольшой набор.
+// Запуск: triangulation_server [--socket PATH] [--threads N]
+//   без --socket - кадры читаются из stdin, ответы пишутся в stdout (протокол - job_protocol.hpp);
+//   с --socket - слушает Unix-сокет, соединений может быть сколько угодно.
+// Запросы считаются на общем пуле с кражей задач (work_stealing_pool.hpp); у каждого потока
+// свои буферы точек, рёбер, ответа и самой триангуляции (TriangulationWorkspace), которые
+// переиспользуются от задачи к задаче.
+// Запрос с kRobust считается triangulate_fast_stream, без него - triangulate_mesh: отсечение
+// кандидатов точно только при robust, а ответ должен совпадать с triangulate() того же правила.
+// Ответы уходят по мере готовности, не обязательно в порядке запросов; пишет их отдельный поток
+// соединения, а не рабочие потоки пула, и у соединения не больше kMaxPending запросов в работе.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <csignal>
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "job_protocol.hpp"
+#include "work_stealing_pool.hpp"
+
+#ifndef JOB_PROTOCOL_POSIX
+int main() {
+    std::cerr << "triangulation_server needs a POSIX system\n";
+    return 1;
+}
+#else
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+// буферы одного рабочего потока
+struct JobArena {
+    PointSet points;
+    std::vector<uint32_t> pairs;
+    std::vector<char> frame;
+    TriangulationWorkspace workspace;
+    size_t jobs = 0;
+};
+
+// сколько запросов одного соединения может быть в работе; дальше чтение запросов ждёт ответов
+static const size_t kMaxPending = 64;
+
+// одно соединение (или stdin/stdout): ответы копятся в очереди и пишутся своим потоком,
+// кадр конца уходит после последнего ответа
+class Connection {
+public:
+    Connection(int in, int out) : in_(in), out_(out), writer_([this] { write_loop(); }) {}
+
+    ~Connection() {
+        finish();
+    }
+
+    int in() const {
+        return in_;
+    }
+
+    // вызывается перед отправкой запроса в пул; ждёт, пока в работе меньше kMaxPending запросов
+    void started() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&] { return pending_ < kMaxPending; });
+        pending_++;
+    }
+
+    // рабочий поток только кладёт копию кадра в очередь
+    void reply(const std::vector<char>& frame) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outbox_.push_back(frame);
+        changed_.notify_all();
+    }
+
+    // дождаться ответов на все запросы и отправить кадр конца
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+            changed_.notify_all();
+        }
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+    }
+
+private:
+    void write_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            changed_.wait(lock, [&] { return !outbox_.empty() || (closing_ && pending_ == 0); });
+            if (outbox_.empty()) {
+                break;
+            }
+            std::vector<char> frame = std::move(outbox_.front());
+            outbox_.pop_front();
+            lock.unlock();
+            // после обрыва ответы выбрасываются, но счёт pending_ продолжается
+            bool ok = broken_ || job_protocol::write_frame(out_, frame);
+            lock.lock();
+            broken_ = broken_ || !ok;
+            pending_--;
+            changed_.notify_all();
+        }
+        if (!broken_) {
+            job_protocol::write_end(out_);
+        }
+    }
+
+    int in_;
+    int out_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::vector<char>> outbox_;
+    size_t pending_ = 0;
+    bool closing_ = false;
+    bool broken_ = false;
+    std::thread writer_;
+};
+
+// читает запросы соединения, пока не придёт кадр конца или не закроется поток
+static void serve(const std::shared_ptr<Connection>& connection, WorkStealingPool<JobArena>& pool) {
+    for (;;) {
+        auto body = std::make_shared<std::vector<char>>();
+        try {
+            if (!job_protocol::read_frame(connection->in(), *body)) {
+                break;
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "error: " << e.what() << "\n";
+            break;
+        }
+        connection->started();
+        pool.submit([connection, body](JobArena& arena) mutable {
+            uint64_t id = 0;
+            try {
+                CrossingRule rule;
+                id = job_protocol::decode_request(*body, rule, arena.points);
+                body.reset();
+                arena.pairs.clear();
+                if (rule == CrossingRule::robust) {
+                    triangulate_fast_stream(arena.points, [&](uint32_t i, uint32_t j) {
+                        arena.pairs.push_back(i);
+                        arena.pairs.push_back(j);
+                    }, rule, arena.workspace);
+                }
+                else {
+                    // сортировка в один поток: параллельность уже даёт пул
+                    EdgeList edges = triangulate_mesh(arena.points, 1, rule, arena.workspace);
+                    for (size_t k = 0; k < edges.size(); k++) {
+                        if (edges.verification[k]) {
+                            arena.pairs.push_back(edges.a[k]);
+                            arena.pairs.push_back(edges.b[k]);
+                        }
+                    }
+                }
+                job_protocol::encode_edges(id, arena.pairs, arena.frame);
+            }
+            catch (const std::exception& e) {
+                job_protocol::encode_error(id, e.what(), arena.frame);
+            }
+            arena.jobs++;
+            connection->reply(arena.frame);
+        });
+    }
+    connection->finish();
+}
+
+static int listen_unix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "error: socket path too long\n";
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::perror("socket");
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        std::perror(path.c_str());
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    std::string socket_path;
+    unsigned threads = 0;
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        if (arg == "--socket" && k + 1 < argc) {
+            socket_path = argv[++k];
+        }
+        else if (arg == "--threads" && k + 1 < argc) {
+            threads = unsigned(std::atoi(argv[++k]));
+        }
+        else {
+            std::cerr << "usage: triangulation_server [--socket PATH] [--threads N]\n"
+                "  without --socket: framed requests on stdin, responses on stdout\n";
+            return 2;
+        }
+    }
+    // клиент может закрыть соединение, не дождавшись ответа - это не повод падать
+    std::signal(SIGPIPE, SIG_IGN);
+
+    WorkStealingPool<JobArena> pool(threads);
+    if (socket_path.empty()) {
+        serve(std::make_shared<Connection>(0, 1), pool);
+        return 0;
+    }
+
+    int listener = listen_unix(socket_path);
+    if (listener < 0) {
+        return 1;
+    }
+    std::cerr << "listening on " << socket_path << " with " << pool.size() << " threads\n";
+    // потоки соединений пользуются пулом, поэтому main не выходит, пока они не закончат;
+    // закончившиеся присоединяются при следующем accept
+    struct Client {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::vector<Client> clients;
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::perror("accept");
+            break;
+        }
+        for (size_t k = 0; k < clients.size();) {
+            if (*clients[k].done) {
+                clients[k].thread.join();
+                clients[k] = std::move(clients.back());
+                clients.pop_back();
+            }
+            else {
+                k++;
+            }
+        }
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        clients.push_back({ std::thread([fd, done, &pool] {
+            serve(std::make_shared<Connection>(fd, fd), pool);
+            close(fd);
+            *done = true;
+        }), done });
+    }
+    close(listener);
+    for (Client& client : clients) {
+        client.thread.join();
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,219 @@
+// Сверка движков жадной триангуляции друг с другом на маленьких вырожденных наборах:
+// пустой, одна точка, совпадающие точки, точки на одной прямой, целочисленные решётки и немного случайных.
+// Эталон - triangulate_mesh (перебор всех пар) с тем же правилом; сам он сверяется с исходным алгоритмом
+// курсовой triangulate_reference(points, true) по legacy.
+// С CrossingRule::robust с эталоном должны совпасть все движки на всех наборах. С legacy отсечение по радиусу
+// веера (fast, lazy, tiled, candidates, DynamicTriangulation) верно только при точках в общем положении,
+// поэтому они сверяются лишь на таких наборах; triangulate_parallel_mesh - на всех.
+// Запуск: triangulation_test [-v]; -v печатает каждую проверку. Код возврата 1, если что-то не совпало.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "lazy_triangulation.hpp"
+#include "tiled_triangulation.hpp"
+#include "candidate_triangulation.hpp"
+#include "parallel_greedy.hpp"
+#include "dynamic_triangulation.hpp"
+#include "point_generators.hpp"
+
+
+struct TestSet {
+    std::string name;
+    PointSet points;
+    bool general;    // точки в общем положении: нет совпадающих, трёх на одной прямой и равных длин
+};
+
+// принятые рёбра по порядку, каждое - пара номеров по возрастанию
+typedef std::vector<std::pair<uint32_t, uint32_t>> Accepted;
+
+static Accepted accepted(const EdgeList& edges) {
+    Accepted result;
+    for (size_t k = 0; k < edges.size(); k++) {
+        if (edges.verification[k]) {
+            result.push_back(std::minmax(edges.a[k], edges.b[k]));
+        }
+    }
+    return result;
+}
+
+static PointSet grid(int columns, int rows, double step) {
+    PointSet points;
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < columns; x++) {
+            points.push_back(x * step, y * step);
+        }
+    }
+    return points;
+}
+
+static PointSet line(size_t n, double dx, double dy) {
+    PointSet points;
+    for (size_t k = 0; k < n; k++) {
+        // не по порядку, чтобы номера не совпадали с порядком на прямой
+        double t = double((k * 7) % n);
+        points.push_back(100 + t * dx, 200 + t * dy);
+    }
+    return points;
+}
+
+static std::vector<TestSet> test_sets() {
+    std::vector<TestSet> sets;
+    sets.push_back({ "empty", PointSet(), true });
+    PointSet one;
+    one.push_back(5, 5);
+    sets.push_back({ "one point", one, true });
+    PointSet two = one;
+    two.push_back(8, 9);
+    sets.push_back({ "two points", two, true });
+    PointSet same = one;
+    same.push_back(5, 5);
+    sets.push_back({ "two equal points", same, false });
+    PointSet copies;
+    for (int k = 0; k < 4; k++) {
+        copies.push_back(0, 0);
+        copies.push_back(10, 0);
+        copies.push_back(3, 7);
+    }
+    sets.push_back({ "triangle x4", copies, false });
+    PointSet doubled = grid(4, 4, 10);
+    for (uint32_t k = 0; k < 16; k += 3) {
+        doubled.push_back(doubled.xs[k], doubled.ys[k]);
+    }
+    sets.push_back({ "grid 4x4 with duplicates", doubled, false });
+    sets.push_back({ "horizontal line", line(12, 5, 0), false });
+    sets.push_back({ "diagonal line", line(12, 3, 3), false });
+    sets.push_back({ "sloped line", line(12, 0.1, 0.3), false });
+    PointSet spoke = line(9, 2, 1);
+    spoke.push_back(120, 150);
+    sets.push_back({ "line and one point", spoke, false });
+    sets.push_back({ "grid 3x3", grid(3, 3, 1), false });
+    sets.push_back({ "grid 5x4", grid(5, 4, 7), false });
+    sets.push_back({ "grid 8x8", grid(8, 8, 1), false });
+    sets.push_back({ "grid 20x15", grid(20, 15, 30), false });
+    for (Distribution d : all_distributions()) {
+        if (d != Distribution::uniform) {
+            sets.push_back({ std::string(distribution_name(d)) + " 150", generate_points(d, 150, 3), false });
+        }
+    }
+    for (unsigned seed = 1; seed <= 4; seed++) {
+        sets.push_back({ "uniform 200 seed " + std::to_string(seed),
+                         generate_points(Distribution::uniform, 200, seed), true });
+    }
+    return sets;
+}
+
+// DynamicTriangulation с нуля по одной точке, затем удаление каждой третьей и возврат их обратно в конец;
+// результат сверяется с triangulate_mesh по живым точкам в порядке номеров (порядок рёбер равной длины зависит от номеров)
+static bool dynamic_matches(const PointSet& points, CrossingRule rule) {
+    DynamicTriangulation dynamic(rule);
+    std::vector<uint32_t> index;
+    for (size_t k = 0; k < points.size(); k++) {
+        index.push_back(dynamic.insert(points[uint32_t(k)]));
+    }
+    for (size_t k = 0; k < points.size(); k += 3) {
+        dynamic.remove(index[k]);
+    }
+    for (size_t k = 0; k < points.size(); k += 3) {
+        dynamic.insert(points[uint32_t(k)]);
+    }
+    std::vector<uint32_t> ids = dynamic.ids();
+    PointSet live;
+    for (uint32_t id : ids) {
+        live.push_back(dynamic.points().xs[id], dynamic.points().ys[id]);
+    }
+    Accepted expected = accepted(triangulate_mesh(live, 1, rule));
+    for (auto& e : expected) {
+        e = std::minmax(ids[e.first], ids[e.second]);
+    }
+    return accepted(dynamic.edges()) == expected;
+}
+
+int main(int argc, char** argv) {
+    bool verbose = argc > 1 && std::string(argv[1]) == "-v";
+    size_t checks = 0, failures = 0;
+    auto check = [&](const std::string& what, bool ok) {
+        checks++;
+        if (!ok) {
+            failures++;
+        }
+        if (!ok || verbose) {
+            std::cout << (ok ? "ok   " : "FAIL ") << what << "\n";
+        }
+    };
+
+    for (const TestSet& set : test_sets()) {
+        const PointSet& points = set.points;
+        std::vector<Point> list(points.size());
+        for (size_t k = 0; k < points.size(); k++) {
+            list[k] = points[uint32_t(k)];
+        }
+
+        // эталон сам по себе: triangulate_mesh по legacy - это алгоритм курсовой
+        if (points.size() <= 150) {
+            std::vector<Edge> reference = triangulate_reference(list, true);
+            std::vector<Edge> mesh = triangulate(list);
+            bool same = reference.size() == mesh.size();
+            for (size_t k = 0; same && k < mesh.size(); k++) {
+                same = reference[k].verification == mesh[k].verification &&
+                       reference[k].A_.x_ == mesh[k].A_.x_ && reference[k].A_.y_ == mesh[k].A_.y_ &&
+                       reference[k].B_.x_ == mesh[k].B_.x_ && reference[k].B_.y_ == mesh[k].B_.y_;
+            }
+            check(set.name + ": triangulate_mesh legacy == triangulate_reference", same);
+        }
+
+        for (CrossingRule rule : { CrossingRule::robust, CrossingRule::legacy }) {
+            std::string suffix = rule == CrossingRule::robust ? " robust" : " legacy";
+            Accepted expected = accepted(triangulate_mesh(points, 1, rule));
+            check(set.name + ": parallel" + suffix, accepted(triangulate_parallel_mesh(points, 2, rule, 4)) == expected);
+            if (rule == CrossingRule::legacy && !set.general) {
+                continue;
+            }
+
+            std::vector<std::pair<std::string, std::function<Accepted()>>> engines = {
+                { "fast", [&] { return accepted(triangulate_fast_mesh(points, rule)); } },
+                { "lazy", [&] { return accepted(triangulate_lazy_mesh(points, rule)); } },
+                { "tiled", [&] {
+                    TileOptions options;
+                    options.rule = rule;
+                    return accepted(triangulate_tiled_mesh(points, options));
+                } },
+                { "tiled x4", [&] {
+                    TileOptions options;
+                    options.tiles = 4;
+                    options.threads = 2;
+                    options.rule = rule;
+                    return accepted(triangulate_tiled_mesh(points, options));
+                } },
+                { "candidates", [&] {
+                    CandidateOptions options;
+                    options.rule = rule;
+                    return accepted(triangulate_candidates_mesh(points, options));
+                } },
+                { "candidates knn", [&] {
+                    CandidateOptions options;
+                    options.delaunay = false;
+                    options.neighbours = 4;
+                    options.rule = rule;
+                    return accepted(triangulate_candidates_mesh(points, options));
+                } },
+                { "dynamic", [&] {
+                    DynamicTriangulation dynamic(points, rule);
+                    return accepted(dynamic.edges());
+                } },
+                            };
+            for (auto& engine : engines) {
+                check(set.name + ": " + engine.first + suffix, engine.second() == expected);
+            }
+            check(set.name + ": dynamic updates" + suffix, dynamic_matches(points, rule));
+        }
+    }
+
+    std::cout << checks << " checks, " << failures << " failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "mesh.hpp"
+#include "triangulate.hpp"
+#include "delaunay.hpp"
+#include "sweep_triangulation.hpp"
+
+
+// Движки триангуляции за общим интерфейсом, чтобы программы выбирали алгоритм ключом.
+// Все три строят полную триангуляцию (3n - 3 - h рёбер у точек не на одной прямой), различаются
+// качеством и скоростью:
+enum class Engine {
+    greedy,     // жадная: самые короткие рёбра, которые ничего не пересекают (triangulate_fast_stream)
+    delaunay,   // Делоне: наибольший наименьший угол; сумма длин обычно на несколько процентов больше
+    sweep       // заметание: быстрее всех, но треугольники длинные и узкие
+};
+
+inline const std::vector<Engine>& all_engines() {
+    static const std::vector<Engine> all = { Engine::greedy, Engine::delaunay, Engine::sweep };
+    return all;
+}
+
+inline const char* engine_name(Engine e) {
+    switch (e) {
+    case Engine::greedy: return "greedy";
+    case Engine::delaunay: return "delaunay";
+    case Engine::sweep: return "sweep";
+    }
+    return "?";
+}
+
+// false - нет такого движка
+inline bool parse_engine(const std::string& name, Engine& e) {
+    for (Engine x : all_engines()) {
+        if (name == engine_name(x)) {
+            e = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Движок: точки -> рёбра (i < j). Объект может хранить буферы между запусками, поэтому один объект
+// не используют из нескольких потоков сразу.
+class Triangulator {
+public:
+    virtual ~Triangulator() = default;
+
+    virtual Engine engine() const = 0;
+
+    // рёбра каждое по разу; жадный отдаёт их в порядке принятия, остальные - в своём порядке
+    virtual EdgeList triangulate(const PointSet& points) = 0;
+};
+
+class GreedyTriangulator : public Triangulator {
+public:
+    explicit GreedyTriangulator(CrossingRule rule = CrossingRule::robust) : rule_(rule) {}
+
+    Engine engine() const override {
+        return Engine::greedy;
+    }
+
+    EdgeList triangulate(const PointSet& points) override {
+        return triangulate_fast_mesh(points, rule_, workspace_);
+    }
+
+private:
+    CrossingRule rule_;
+    TriangulationWorkspace workspace_;
+};
+
+class DelaunayTriangulator : public Triangulator {
+public:
+    Engine engine() const override {
+        return Engine::delaunay;
+    }
+
+    EdgeList triangulate(const PointSet& points) override {
+        return triangulate_delaunay(points);
+    }
+};
+
+class SweepTriangulator : public Triangulator {
+public:
+    Engine engine() const override {
+        return Engine::sweep;
+    }
+
+    EdgeList triangulate(const PointSet& points) override {
+        return triangulate_sweep(points);
+    }
+};
+
+// rule нужен только жадному: Делоне и заметание всегда считают точными предикатами
+inline std::unique_ptr<Triangulator> make_triangulator(Engine engine, CrossingRule rule = CrossingRule::robust) {
+    switch (engine) {
+    case Engine::delaunay: return std::make_unique<DelaunayTriangulator>();
+    case Engine::sweep: return std::make_unique<SweepTriangulator>();
+    case Engine::greedy: break;
+    }
+    return std::make_unique<GreedyTriangulator>(rule);
+}
+
+// сумма длин рёбер - мера качества: жадная триангуляция приближает триангуляцию наименьшей суммы
+inline double total_length(const PointSet& points, const EdgeList& edges) {
+    double sum = 0;
+    for (size_t k = 0; k < edges.size(); k++) {
+        sum += points.length(edges.a[k], edges.b[k]);
+    }
+    return sum;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+
+// Пул потоков для множества независимых задач (например, запросов сервера).
+// У каждого потока своя очередь и своя "арена" Arena - буферы, которые переживают задачи и
+// переиспользуются следующими (задача получает арену своего потока). Поток берёт задачи из своей
+// очереди, а опустев - крадёт из чужих; и то и другое - самые старые, чтобы ранние запросы
+// не ждали за поздними. Задачи снаружи раскладываются по очередям по кругу, задачи из задач -
+// в очередь своего потока.
+template <class Arena>
+class WorkStealingPool {
+public:
+    using Task = std::function<void(Arena&)>;
+
+    // threads - число рабочих потоков (0 - по числу ядер)
+    explicit WorkStealingPool(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned t = 0; t < threads; t++) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (unsigned t = 0; t < threads; t++) {
+            workers_[t]->thread = std::thread([this, t] { loop(t); });
+        }
+    }
+
+    // дожидается всех поставленных задач
+    ~WorkStealingPool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& w : workers_) {
+            w->thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const {
+        return unsigned(workers_.size());
+    }
+
+    void submit(Task task) {
+        size_t target = current_pool() == this ? current_worker() : next_++ % workers_.size();
+        // до того как задачу увидят: иначе украденная и выполненная задача опустит счётчик до нуля
+        // раньше, чем он вырос, и wait() вернётся при невыполненных задачах
+        pending_++;
+        {
+            std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+            workers_[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            queued_++;
+        }
+        wake_.notify_one();
+    }
+
+    // ждать, пока не будут выполнены все поставленные задачи
+    void wait() {
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        idle_.wait(lock, [&] { return pending_ == 0; });
+    }
+
+    // сколько задач взято из чужих очередей
+    size_t steals() const {
+        return steals_;
+    }
+
+    // арена потока t; трогать только когда пул стоит (после wait())
+    Arena& arena(unsigned t) {
+        return workers_[t]->arena;
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        Arena arena;
+        std::thread thread;
+    };
+
+    static const WorkStealingPool*& current_pool() {
+        thread_local const WorkStealingPool* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& current_worker() {
+        thread_local size_t worker = 0;
+        return worker;
+    }
+
+    // самая старая задача из своей очереди, иначе из первой непустой чужой
+    bool take(size_t self, Task& task) {
+        for (size_t k = 0; k < workers_.size(); k++) {
+            Worker& w = *workers_[(self + k) % workers_.size()];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (!w.tasks.empty()) {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+                if (k > 0) {
+                    steals_++;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void loop(size_t self) {
+        current_pool() = this;
+        current_worker() = self;
+        Task task;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                wake_.wait(lock, [&] { return stop_ || queued_ > 0; });
+                if (stop_ && queued_ == 0) {
+                    return;
+                }
+                queued_--;
+            }
+            // счётчик queued_ гарантирует, что задача для нас в какой-то очереди есть
+            while (!take(self, task)) {
+                std::this_thread::yield();
+            }
+            task(workers_[self]->arena);
+            task = nullptr;
+            if (--pending_ == 0) {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                idle_.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    size_t queued_ = 0;                  // поставлено и ещё не разобрано потоками (под sleep_mutex_)
+    std::atomic<size_t> pending_{ 0 };   // поставлено и ещё не выполнено
+    std::atomic<size_t> next_{ 0 };
+    std::atomic<size_t> steals_{ 0 };
+    bool stop_ = false;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+
+// Постоянный набор потоков для parallel_for: потоки создаются один раз и ждут работу,
+// а не запускаются заново на каждую пачку.
+class WorkerPool {
+public:
+    // threads - общее число потоков вместе с вызывающим (0 - по числу ядер)
+    explicit WorkerPool(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned t = 1; t < threads; t++) {
+            workers_.emplace_back([this] { loop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : workers_) {
+            t.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const {
+        return unsigned(workers_.size()) + 1;
+    }
+
+    // вызывает fn(i) для всех i из [0, count) кусками по chunk; вызывающий поток тоже работает
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn, size_t chunk = 64) {
+        if (workers_.empty() || count <= chunk) {
+            for (size_t i = 0; i < count; i++) {
+                fn(i);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &fn;
+            count_ = count;
+            chunk_ = chunk;
+            next_ = 0;
+            busy_ = workers_.size();
+            generation_++;
+        }
+        wake_.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return busy_ == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    void work() {
+        for (;;) {
+            size_t begin = next_.fetch_add(chunk_);
+            if (begin >= count_) {
+                return;
+            }
+            size_t end = std::min(count_, begin + chunk_);
+            for (size_t i = begin; i < end; i++) {
+                (*job_)(i);
+            }
+        }
+    }
+
+    void loop() {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+            }
+            work();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                busy_--;
+            }
+            done_.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* job_ = nullptr;
+    size_t count_ = 0;
+    size_t chunk_ = 1;
+    std::atomic<size_t> next_{ 0 };
+    size_t busy_ = 0;
+    size_t generation_ = 0;
+    bool stop_ = false;
+};